@@ -0,0 +1,52 @@
+/**
+ * @file backtracking.cc
+ * @author Simone Ancona
+ * @brief Parsing with a grammar whose expressions share long prefixes, so most attempts fail and backtrack
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+// Every statement starts with an identifier, so the FIRST sets cannot tell the expressions apart
+static const std::string grammar = R"json({
+    "name": "backtracking",
+    "terminals": [],
+    "rules": [
+        {"name": "program", "expressions": ["<statement*><eof>"]},
+        {"name": "statement", "expressions": ["<assignment>;<newLine>", "<increment>;<newLine>", "<call>;<newLine>"]},
+        {"name": "assignment", "expressions": ["<identifier>=<operand>"]},
+        {"name": "increment", "expressions": ["<identifier>+=<operand>"]},
+        {"name": "call", "expressions": ["<identifier>(<arguments?>)"]},
+        {"name": "arguments", "expressions": ["<operand><argument*>"]},
+        {"name": "argument", "expressions": [",<operand>"]},
+        {"name": "operand", "expressions": ["<call>", "<identifier>", "<integer>"]}
+    ]
+})json";
+
+static void run(Xpp::Parser &parser, const std::string &input, Xpp::ParserEngine engine, const char *label)
+{
+    parser.set_engine(engine);
+    double elapsed = Bench::measure([&]
+                                    { parser.generate_ast(input); });
+    Bench::report(label, elapsed, input.size());
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = Bench::size_argument(argc, argv, 1, 1 << 20);
+    static const std::string lines = "total=add(first,second,3);\ncounter+=step(1);\nprint(total,counter);\n";
+    std::string input;
+    while (input.size() < size)
+        input += lines;
+
+    Xpp::Parser parser(grammar);
+    std::printf("input: %zu bytes\n", input.size());
+    run(parser, input, Xpp::ENGINE_RECURSIVE, "recursive");
+    run(parser, input, Xpp::ENGINE_ITERATIVE, "iterative");
+    return 0;
+}
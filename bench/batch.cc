@@ -0,0 +1,56 @@
+/**
+ * @file batch.cc
+ * @author Simone Ancona
+ * @brief Throughput of parse_batch against a loop of generate_ast on many small documents
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+int main(int argc, char **argv)
+{
+    size_t count = Bench::size_argument(argc, argv, 1, 200000);
+    size_t max_threads = Bench::size_argument(argc, argv, 2, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::string> documents;
+    documents.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        documents.push_back("{\"id\" : " + std::to_string(i) + ",\"tags\" : [\"a\",\"b\"],\"ok\" : " + (i % 2 ? "true" : "false") + "}");
+    std::vector<std::string_view> views(documents.begin(), documents.end());
+
+    Xpp::Parser parser(Bench::json_grammar());
+    size_t parsed = 0;
+    char label[64];
+
+    std::printf("documents: %zu\n", count);
+    // Both keep every result until the end, like parse_batch does
+    double loop = Bench::measure([&]
+                                 {
+                                     std::vector<Xpp::ParseResult> results;
+                                     results.reserve(views.size());
+                                     for (std::string_view view : views)
+                                         results.push_back(parser.try_generate_ast(view));
+                                     for (const Xpp::ParseResult &result : results)
+                                         parsed += result.success;
+                                 });
+    std::printf("%-32s %10.4f s %12.0f documents/s\n", "generate_ast loop", loop, count / loop);
+
+    for (size_t threads = 1; threads <= max_threads; threads = Bench::next_thread_count(threads, max_threads))
+    {
+        parser.set_batch_options({threads});
+        parser.parse_batch(std::span<const std::string_view>(views.data(), std::min<size_t>(views.size(), 1024)));
+        double elapsed = Bench::measure([&]
+                                        {
+                                            for (const Xpp::ParseResult &result : parser.parse_batch(views))
+                                                parsed += result.success;
+                                        });
+        std::snprintf(label, sizeof(label), "parse_batch %zu threads (%.2fx)", threads, loop / elapsed);
+        std::printf("%-32s %10.4f s %12.0f documents/s\n", label, elapsed, count / elapsed);
+    }
+    std::printf("parsed: %zu\n", parsed);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file bench.hh
+ * @author Simone Ancona
+ * @brief Helpers shared by the benchmarks
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "xparser.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace Bench
+{
+    /**
+     * @brief Run a function and return the elapsed time in seconds
+     *
+     */
+    template <typename F>
+    inline double measure(F &&function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief Read a size argument from the command line, falling back to a default value
+     *
+     */
+    inline size_t size_argument(int argc, char **argv, int index, size_t default_value)
+    {
+        if (argc > index)
+            return std::strtoull(argv[index], nullptr, 10);
+        return default_value;
+    }
+
+    /**
+     * @brief Print a result line as "<label>: <seconds> s, <seconds per MB> s/MB"
+     *
+     */
+    inline void report(const char *label, double seconds, size_t bytes)
+    {
+        std::printf("%-32s %10.4f s %12.4f s/MB\n", label, seconds, seconds / (static_cast<double>(bytes) / (1024.0 * 1024.0)));
+    }
+
+    /**
+     * @brief Get the thread count that follows threads when sweeping from 1 to max_threads, the powers of two and
+     * then max_threads itself
+     *
+     */
+    inline size_t next_thread_count(size_t threads, size_t max_threads)
+    {
+        return (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2;
+    }
+
+    /**
+     * @brief Read json/jsonGrammar.json, exiting if the benchmark is not run from the build directory
+     *
+     */
+    inline std::string json_grammar()
+    {
+        std::ifstream file;
+        file.open("json/jsonGrammar.json");
+        if (file.fail())
+        {
+            std::printf("run the benchmark from the build directory, json/jsonGrammar.json is required\n");
+            std::exit(1);
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    /**
+     * @brief Build a JSON array of items with nested objects, arrays and every kind of value
+     *
+     */
+    inline std::string json_input(size_t items)
+    {
+        std::string input = "[";
+        for (size_t i = 0; i < items; i++)
+            input += "{\"key\" : [1,2.5,\"text\",true,null,{\"nested\" : {}}]},";
+        input += "[]]";
+        return input;
+    }
+
+    /**
+     * @brief Parse the input with the given engine and report the result
+     *
+     */
+    inline void run_engine(Xpp::Parser &parser, const std::string &input, Xpp::ParserEngine engine, const char *label)
+    {
+        parser.set_engine(engine);
+        double elapsed = measure([&]
+                                 { parser.generate_ast(input); });
+        report(label, elapsed, input.size());
+    }
+};
@@ -0,0 +1,58 @@
+/**
+ * @file budget.cc
+ * @author Simone Ancona
+ * @brief Cost of the budget checks and a time limit on a grammar that backtracks exponentially
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+// Every level matches the whole nested input with the first expression before failing on '!'
+static const std::string exponential_grammar = R"json({
+    "name": "exponential",
+    "terminals": [],
+    "rules": [
+        {"name": "group", "expressions": ["(<group>)!", "(<group>)?", "()"]}
+    ]
+})json";
+
+int main(int argc, char **argv)
+{
+    size_t items = Bench::size_argument(argc, argv, 1, 20000);
+    size_t depth = Bench::size_argument(argc, argv, 2, 40);
+    std::string input = Bench::json_input(items);
+
+    Xpp::Parser parser(Bench::json_grammar());
+    std::printf("input: %zu bytes\n", input.size());
+    double elapsed = Bench::measure([&]
+                                    { parser.generate_ast(std::string_view(input)); });
+    Bench::report("no budget", elapsed, input.size());
+    Xpp::ParseBudget budget;
+    budget.max_steps = SIZE_MAX - 1;
+    budget.max_nodes = SIZE_MAX - 1;
+    budget.time_limit = std::chrono::hours(1);
+    budget.cancellation = std::make_shared<Xpp::CancellationToken>();
+    parser.set_budget(budget);
+    elapsed = Bench::measure([&]
+                             { parser.generate_ast(std::string_view(input)); });
+    Bench::report("every limit", elapsed, input.size());
+
+    Xpp::Parser exponential_parser(exponential_grammar);
+    std::string nested;
+    for (size_t i = 0; i < depth; i++)
+        nested = "(" + nested + ")?";
+    nested = "(" + nested + ")?";
+    budget = {};
+    budget.time_limit = std::chrono::milliseconds(10);
+    exponential_parser.set_budget(budget);
+    Xpp::ParseResult result;
+    elapsed = Bench::measure([&]
+                             { result = exponential_parser.try_generate_ast(nested); });
+    std::printf("exponential input: depth %zu, stopped: %s after %.4f s\n", depth, result.error.type == Xpp::TIME_LIMIT_EXCEEDED ? "yes" : "no", elapsed);
+    return 0;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file bytecode.cc
+ * @author Simone Ancona
+ * @brief The bytecode engine against the recursive and iterative engines
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+int main(int argc, char **argv)
+{
+    size_t items = Bench::size_argument(argc, argv, 1, 20000);
+    std::string input = Bench::json_input(items);
+
+    Xpp::Parser parser(Bench::json_grammar());
+    const Xpp::Bytecode &program = parser.get_grammar()->get_bytecode();
+    std::printf("program: %zu instructions, %zu bytes\n", program.get_code().size(), program.get_code().size() * sizeof(Xpp::Instruction));
+    std::printf("input: %zu bytes\n", input.size());
+    Bench::run_engine(parser, input, Xpp::ENGINE_RECURSIVE, "recursive");
+    Bench::run_engine(parser, input, Xpp::ENGINE_ITERATIVE, "iterative");
+    Bench::run_engine(parser, input, Xpp::ENGINE_BYTECODE, "bytecode");
+    parser.set_prediction(false);
+    Bench::run_engine(parser, input, Xpp::ENGINE_RECURSIVE, "recursive, no prediction");
+    Bench::run_engine(parser, input, Xpp::ENGINE_BYTECODE, "bytecode, no prediction");
+    return 0;
+}
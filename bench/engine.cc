@@ -0,0 +1,40 @@
+/**
+ * @file engine.cc
+ * @author Simone Ancona
+ * @brief Recursive and iterative engines on shallow and deeply nested inputs
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+static const std::string nesting_grammar = R"json({
+    "name": "nesting",
+    "terminals": [],
+    "rules": [
+        {"name": "list", "expressions": ["(<list?>)"]}
+    ]
+})json";
+
+int main(int argc, char **argv)
+{
+    size_t items = Bench::size_argument(argc, argv, 1, 20000);
+    size_t depth = Bench::size_argument(argc, argv, 2, 1000000);
+    std::string input = Bench::json_input(items);
+
+    Xpp::Parser parser(Bench::json_grammar());
+    std::printf("shallow input: %zu bytes\n", input.size());
+    Bench::run_engine(parser, input, Xpp::ENGINE_RECURSIVE, "recursive");
+    Bench::run_engine(parser, input, Xpp::ENGINE_ITERATIVE, "iterative");
+
+    // The recursive engine would overflow the stack on this input
+    Xpp::Parser nesting_parser(nesting_grammar);
+    std::string nested = std::string(depth, '(') + std::string(depth, ')');
+    std::printf("nested input: depth %zu\n", depth);
+    Bench::run_engine(nesting_parser, nested, Xpp::ENGINE_ITERATIVE, "iterative");
+    return 0;
+}
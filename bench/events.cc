@@ -0,0 +1,75 @@
+/**
+ * @file events.cc
+ * @author Simone Ancona
+ * @brief Counting the nodes of an input with parse_events against building the AST
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+// Counts the rules and the terminals, the counts are saved at every begin so a rollback restores them
+class Counter : public Xpp::EventHandler
+{
+public:
+    size_t nodes = 0;
+    std::vector<size_t> saved;
+    size_t max_saved = 0;
+
+    void enter_rule(const Xpp::Rule &, size_t) override { nodes++; }
+    void exit_rule(const Xpp::Rule &, std::string_view) override {}
+    void terminal(const Xpp::Rule &, std::string_view) override { nodes++; }
+    void begin() override
+    {
+        saved.push_back(nodes);
+        max_saved = std::max(max_saved, saved.size());
+    }
+    void commit() override { saved.pop_back(); }
+    void rollback() override
+    {
+        nodes = saved.back();
+        saved.pop_back();
+    }
+};
+
+static size_t count_nodes(Xpp::AST &ast)
+{
+    if (ast.is_terminal())
+        return 1;
+    size_t nodes = 1;
+    for (Xpp::AST &child : ast.get_children())
+        nodes += count_nodes(child);
+    return nodes;
+}
+
+int main(int argc, char **argv)
+{
+    size_t items = Bench::size_argument(argc, argv, 1, 20000);
+    std::string input = Bench::json_input(items);
+
+    Xpp::Parser parser(Bench::json_grammar());
+    size_t ast_nodes = 0;
+    Counter counter;
+    Counter forwarded;
+    Xpp::EventBuffer buffer(forwarded);
+
+    std::printf("input: %zu bytes\n", input.size());
+    double elapsed = Bench::measure([&]
+                                    {
+                                        Xpp::AST ast = parser.generate_ast(std::string_view(input));
+                                        ast_nodes = count_nodes(ast);
+                                    });
+    Bench::report("generate_ast", elapsed, input.size());
+    elapsed = Bench::measure([&]
+                             { parser.parse_events(input, counter); });
+    Bench::report("parse_events", elapsed, input.size());
+    elapsed = Bench::measure([&]
+                             { parser.parse_events(input, buffer); });
+    Bench::report("parse_events with EventBuffer", elapsed, input.size());
+    std::printf("nodes: %zu %zu %zu, open attempts: %zu\n", ast_nodes, counter.nodes, forwarded.nodes, counter.max_saved);
+    return 0;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file generated.cc
+ * @author Simone Ancona
+ * @brief Parsing a JSON input with the interpreted parser against the parser generated by xparse-gen
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "JsonParser.hh"
+#include "bench.hh"
+
+int main(int argc, char **argv)
+{
+    size_t items = Bench::size_argument(argc, argv, 1, 20000);
+    std::string input = Bench::json_input(items);
+
+    Xpp::Parser parser(Bench::json_grammar());
+    JsonParser generated;
+    size_t interpreted_nodes = 0;
+    size_t generated_nodes = 0;
+
+    std::printf("input: %zu bytes\n", input.size());
+    double elapsed = Bench::measure([&]
+                                    { interpreted_nodes = parser.generate_ast(std::string_view(input)).get_children().size(); });
+    Bench::report("interpreted", elapsed, input.size());
+    parser.set_engine(Xpp::ENGINE_ITERATIVE);
+    elapsed = Bench::measure([&]
+                             { parser.generate_ast(std::string_view(input)); });
+    Bench::report("interpreted, iterative engine", elapsed, input.size());
+    elapsed = Bench::measure([&]
+                             { generated_nodes = generated.generate_ast(std::string_view(input)).get_children().size(); });
+    Bench::report("generated", elapsed, input.size());
+    std::printf("root children: %zu %zu\n", interpreted_nodes, generated_nodes);
+    return 0;
+}
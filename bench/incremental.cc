@@ -0,0 +1,60 @@
+/**
+ * @file incremental.cc
+ * @author Simone Ancona
+ * @brief Latency of reparse after a one-character edit against a full parse of the edited input
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+int main(int argc, char **argv)
+{
+    size_t bytes = Bench::size_argument(argc, argv, 1, 1024 * 1024);
+    size_t edits = Bench::size_argument(argc, argv, 2, 20);
+    // Nested groups keep the number of children of every node small, like the sections of a real document
+    std::string group = "[";
+    for (size_t i = 0; i < 64; i++)
+        group += "{\"key\" : [1,2.5,\"text\",true,null]},";
+    group += "[]]";
+    std::string input = "[";
+    while (input.size() < bytes)
+        input += group + ",";
+    input += "[]]";
+
+    std::string grammar = Bench::json_grammar();
+    Xpp::Parser full_parser(grammar);
+    Xpp::Parser incremental_parser(grammar);
+    incremental_parser.set_incremental(true);
+    Xpp::ParseResult result = incremental_parser.try_generate_ast(input);
+
+    // Every edit replaces the digit of an integer spread over the whole input
+    std::vector<size_t> offsets;
+    for (size_t offset = input.find("[1,"); offset != std::string::npos; offset = input.find("[1,", offset + 1))
+        offsets.push_back(offset + 1);
+    size_t parsed = 0;
+    double full = 0;
+    double incremental = 0;
+    for (size_t i = 0; i < edits; i++)
+    {
+        size_t offset = offsets[i * 7919 % offsets.size()];
+        std::string digit(1, static_cast<char>('1' + (i % 9)));
+        input[offset] = digit[0];
+        full += Bench::measure([&]
+                               { parsed += full_parser.try_generate_ast(input).success; });
+        incremental += Bench::measure([&]
+                                      {
+                                          result = incremental_parser.reparse(std::move(result.ast), {{offset, 1, digit}});
+                                          parsed += result.success;
+                                      });
+    }
+    std::printf("input: %zu bytes, %zu edits\n", input.size(), edits);
+    std::printf("%-32s %10.6f s per edit\n", "try_generate_ast", full / edits);
+    std::printf("%-32s %10.6f s per edit (%.1fx)\n", "reparse", incremental / edits, full / incremental);
+    std::printf("parsed: %zu\n", parsed);
+    return 0;
+}
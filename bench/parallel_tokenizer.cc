@@ -0,0 +1,56 @@
+/**
+ * @file parallel_tokenizer.cc
+ * @author Simone Ancona
+ * @brief Scaling of the parallel tokenizer from 1 to N threads
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+static const std::string grammar = R"({
+    "name": "bench",
+    "terminals": [
+        {"name": "string", "regex": "\"[^\"]*\""},
+        {"name": "boolean", "regex": "true|false"}
+    ],
+    "rules": [
+        {"name": "file", "expressions": ["<identifier>"]}
+    ]
+})";
+
+int main(int argc, char **argv)
+{
+    size_t size = Bench::size_argument(argc, argv, 1, 256 * 1024 * 1024);
+    size_t max_threads = Bench::size_argument(argc, argv, 2, std::max(1u, std::thread::hardware_concurrency()));
+    size_t chunk_size = Bench::size_argument(argc, argv, 3, 1 << 20);
+    static const std::string line = "let value_1 = 42 + 3.14 * \"text\" == true\n";
+    std::string input;
+    input.reserve(size + line.size());
+    while (input.size() < size)
+        input += line;
+
+    Xpp::Parser parser(grammar);
+    size_t count = 0;
+    char label[64];
+    double single = 0;
+    double elapsed;
+
+    std::printf("input: %zu bytes, chunks of %zu bytes\n", input.size(), chunk_size);
+    for (size_t threads = 1; threads <= max_threads; threads = Bench::next_thread_count(threads, max_threads))
+    {
+        parser.set_tokenizer_options({threads, chunk_size});
+        elapsed = Bench::measure([&]
+                                 { count = parser.tokenize(input).size(); });
+        if (threads == 1)
+            single = elapsed;
+        std::snprintf(label, sizeof(label), "%zu threads (%.2fx)", threads, single / elapsed);
+        Bench::report(label, elapsed, input.size());
+    }
+    std::printf("tokens: %zu\n", count);
+    return 0;
+}
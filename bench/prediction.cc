@@ -0,0 +1,37 @@
+/**
+ * @file prediction.cc
+ * @author Simone Ancona
+ * @brief Expressions and alternatives skipped by predictive parsing on the JSON grammar
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+static void run(Xpp::Parser &parser, const std::string &input, bool prediction)
+{
+    parser.set_prediction(prediction);
+    double elapsed = Bench::measure([&]
+                                    { parser.generate_ast(input); });
+    const Xpp::PredictionStatistics &statistics = parser.get_prediction_statistics();
+    Bench::report(prediction ? "prediction" : "no prediction", elapsed, input.size());
+    std::printf("  expressions: %zu tried, %zu pruned\n", statistics.expressions_tried, statistics.expressions_pruned);
+    std::printf("  alternatives: %zu tried, %zu pruned\n", statistics.alternatives_tried, statistics.alternatives_pruned);
+}
+
+int main(int argc, char **argv)
+{
+    size_t items = Bench::size_argument(argc, argv, 1, 20000);
+    std::string input = Bench::json_input(items);
+
+    Xpp::Parser parser(Bench::json_grammar());
+
+    std::printf("input: %zu bytes\n", input.size());
+    run(parser, input, false);
+    run(parser, input, true);
+    return 0;
+}
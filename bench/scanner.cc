@@ -0,0 +1,135 @@
+/**
+ * @file scanner.cc
+ * @author Simone Ancona
+ * @brief Character class scanners: scalar, SSE2 and AVX2 against std::regex
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "scanner.hh"
+#include "bench.hh"
+#include <regex>
+#include <vector>
+
+struct ClassCase
+{
+    const char *name;
+    Xpp::CharacterClass cls;
+    const char *alphabet;
+    const char *regex;
+};
+
+static const ClassCase classes[] = {
+    {"alnum", Xpp::CLASS_ALNUM, "aZ09xY", "[a-zA-Z0-9]+"},
+    {"digit", Xpp::CLASS_DIGIT, "0123456789", "[0-9]+"},
+    {"alpha", Xpp::CLASS_ALPHA, "abcXYZ", "[a-zA-Z]+"},
+    {"space", Xpp::CLASS_SPACE, " \t ", "[^\\S\\r\\n]+"},
+    {"hexDigit", Xpp::CLASS_HEX_DIGIT, "09afAF", "[0-9a-fA-F]+"},
+    {"octDigit", Xpp::CLASS_OCT_DIGIT, "01234567", "[0-7]+"},
+    {"any", Xpp::CLASS_ANY, "a; {}", ".+"},
+    {"identifier tail", Xpp::CLASS_IDENTIFIER, "a_Z9", "[_a-zA-Z0-9]+"},
+};
+
+struct TerminalCase
+{
+    const char *name;
+    size_t (*scanner)(const char *, size_t) noexcept;
+    const char *sample;
+    const char *regex;
+};
+
+static const TerminalCase terminals[] = {
+    {"integer", Xpp::Scanner::scan_integer, "-1234567890", "[-+]?\\d+"},
+    {"identifier", Xpp::Scanner::scan_identifier, "_identifier_name42", "[_a-zA-Z][_a-zA-Z0-9]*"},
+    {"real", Xpp::Scanner::scan_real, "+3141.59265", "[-+]?\\d+(\\.\\d+)?"},
+};
+
+// Runs of `run` characters taken from the alphabet, each followed by a byte that ends the run
+static std::string generate_runs(const std::string &alphabet, size_t size, size_t run)
+{
+    std::string input;
+    input.reserve(size + run + 1);
+    while (input.size() < size)
+    {
+        for (size_t i = 0; i < run; i++)
+            input += alphabet[i % alphabet.size()];
+        input += '\n';
+    }
+    return input;
+}
+
+template <typename Scan>
+static size_t scan_all(const std::string &input, Scan scan)
+{
+    size_t i = 0;
+    size_t total = 0;
+    size_t length;
+    while (i < input.size())
+    {
+        length = scan(input.data() + i, input.size() - i);
+        total += length;
+        i += length + 1;
+    }
+    return total;
+}
+
+static size_t regex_scan_all(const std::string &input, const std::regex &regex)
+{
+    return scan_all(input, [&](const char *data, size_t length) -> size_t
+                    {
+                        std::cmatch m;
+                        if (!std::regex_search(data, data + length, m, regex, std::regex_constants::match_continuous))
+                            return 0;
+                        return m.length(0); });
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = Bench::size_argument(argc, argv, 1, 4 * 1024 * 1024);
+    size_t run = Bench::size_argument(argc, argv, 2, 64);
+    const Xpp::ScannerLevel levels[] = {Xpp::SCANNER_SCALAR, Xpp::SCANNER_SSE2, Xpp::SCANNER_AVX2};
+    const char *level_names[] = {"scalar", "sse2", "avx2"};
+    char label[64];
+    volatile size_t sink = 0;
+
+    std::printf("input: %zu bytes, runs of %zu characters, best level: %s\n", size, run, level_names[Xpp::Scanner::get_level()]);
+    for (const auto &c : classes)
+    {
+        std::string input = generate_runs(c.alphabet, size, run);
+        std::regex regex(c.regex, std::regex::ECMAScript | std::regex::optimize);
+        for (auto level : levels)
+        {
+            if (!Xpp::Scanner::is_supported(level))
+                continue;
+            std::snprintf(label, sizeof(label), "%s (%s)", c.name, level_names[level]);
+            Bench::report(label, Bench::measure([&]
+                                                { sink = sink + scan_all(input, [&](const char *data, size_t length)
+                                                                         { return Xpp::Scanner::scan(c.cls, data, length, level); }); }),
+                          input.size());
+        }
+        std::snprintf(label, sizeof(label), "%s (std::regex)", c.name);
+        Bench::report(label, Bench::measure([&]
+                                            { sink = sink + regex_scan_all(input, regex); }),
+                      input.size());
+    }
+
+    for (const auto &t : terminals)
+    {
+        std::string input;
+        while (input.size() < size)
+            input += std::string(t.sample) + " ";
+        std::regex regex(t.regex, std::regex::ECMAScript | std::regex::optimize);
+        std::snprintf(label, sizeof(label), "%s (scanner)", t.name);
+        Bench::report(label, Bench::measure([&]
+                                            { sink = sink + scan_all(input, t.scanner); }),
+                      input.size());
+        std::snprintf(label, sizeof(label), "%s (std::regex)", t.name);
+        Bench::report(label, Bench::measure([&]
+                                            { sink = sink + regex_scan_all(input, regex); }),
+                      input.size());
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file spaces.cc
+ * @author Simone Ancona
+ * @brief The 's' flag against references to spaces written in the expressions
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+// The same language, the spaces are matched by a rule in the first grammar and skipped by the flag in the second
+static const char *referenced_grammar = R"json({"name": "block", "terminals": [], "rules": [
+    {"name": "block", "expressions": ["{<statement*><gap>}"]},
+    {"name": "statement", "expressions": ["<gap>let<gap><identifier><gap>=<gap><integer|identifier><gap>;", "<gap>print<gap>(<gap><identifier><gap>)<gap>;"]},
+    {"name": "gap", "expressions": ["<space*>"]}]})json";
+
+static const char *flagged_grammar = R"json({"name": "block", "terminals": [], "rules": [
+    {"name": "block", "expressions": ["[s]{<statement*><space*>}"]},
+    {"name": "statement", "expressions": ["[sb]<space*>let <identifier> = <integer|identifier> ;", "[s]<space*>print ( <identifier> ) ;"]}]})json";
+
+static void run(Xpp::Parser &parser, const std::string &input, Xpp::ParserEngine engine, const char *label)
+{
+    parser.set_engine(engine);
+    double elapsed = Bench::measure([&]
+                                    { parser.generate_ast(input); });
+    Bench::report(label, elapsed, input.size());
+}
+
+int main(int argc, char **argv)
+{
+    size_t statements = Bench::size_argument(argc, argv, 1, 50000);
+    std::string input = "{";
+    for (size_t i = 0; i < statements; i++)
+        input += i % 2 == 0 ? "    let   value" + std::to_string(i) + "   =   " + std::to_string(i) + " ;" : "\tprint ( value" + std::to_string(i - 1) + " ) ;";
+    input += "   }";
+    std::printf("input: %zu bytes\n", input.size());
+
+    Xpp::Parser referenced{std::string(referenced_grammar)};
+    Xpp::Parser flagged{std::string(flagged_grammar)};
+    run(referenced, input, Xpp::ENGINE_RECURSIVE, "<space*> references");
+    run(flagged, input, Xpp::ENGINE_RECURSIVE, "'s' flag");
+    run(referenced, input, Xpp::ENGINE_BYTECODE, "<space*> references, bytecode");
+    run(flagged, input, Xpp::ENGINE_BYTECODE, "'s' flag, bytecode");
+    return 0;
+}
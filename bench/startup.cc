@@ -0,0 +1,59 @@
+/**
+ * @file startup.cc
+ * @author Simone Ancona
+ * @brief Loading a grammar from its JSON definition against loading its binary image
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+static void run(const std::string &json, const std::string &image, size_t loads, const char *label)
+{
+    size_t rules = 0;
+    double json_elapsed = Bench::measure([&]
+                                         {
+                                             for (size_t i = 0; i < loads; i++)
+                                                 rules += Xpp::Parser(json).get_grammar()->get_rules().size();
+                                         });
+    double image_elapsed = Bench::measure([&]
+                                          {
+                                              for (size_t i = 0; i < loads; i++)
+                                              {
+                                                  Xpp::Parser parser;
+                                                  parser.load_compiled(image);
+                                                  rules += parser.get_grammar()->get_rules().size();
+                                              }
+                                          });
+    std::printf("%s\n", label);
+    std::printf("%-32s %10.3f us\n", "  JSON grammar", json_elapsed * 1e6 / loads);
+    std::printf("%-32s %10.3f us\n", "  binary image", image_elapsed * 1e6 / loads);
+    std::printf("%-32s %10zu\n", "  rules loaded", rules);
+}
+
+int main(int argc, char **argv)
+{
+    size_t loads = Bench::size_argument(argc, argv, 1, 1000);
+    size_t generated_rules = Bench::size_argument(argc, argv, 2, 500);
+
+    std::string json = Bench::json_grammar();
+    Xpp::Parser(json).save_compiled("jsonGrammar.xpg");
+    run(json, "jsonGrammar.xpg", loads, "JSON grammar");
+
+    // Every rule has a few expressions with constants, alternatives and quantifiers
+    std::string large = R"({"name": "large", "terminals": [{"name": "word", "regex": "[a-z]+"}], "rules": [)";
+    for (size_t i = 0; i < generated_rules; i++)
+    {
+        std::string next = i + 1 < generated_rules ? "<rule" + std::to_string(i + 1) + "?>" : "";
+        large += std::string(i == 0 ? "" : ",") + R"({"name": "rule)" + std::to_string(i) + R"(", "expressions": [)";
+        large += R"("key)" + std::to_string(i) + R"( = <integer|word>;)" + next + R"(", "[i]block)" + std::to_string(i) + R"( {<digit{1:3}>}", "<alpha+>)" + next + R"("]})";
+    }
+    large += "]}";
+    Xpp::Parser(large).save_compiled("large.xpg");
+    run(large, "large.xpg", std::max<size_t>(loads / 20, 1), "generated grammar");
+    return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file static_grammar.cc
+ * @author Simone Ancona
+ * @brief Loading and using a grammar at runtime against the same grammar checked at compile time
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "static_grammar.hh"
+#include "bench.hh"
+
+using StaticJson = Xpp::StaticParser<
+    Xpp::StaticRule<"jsonFile", "<object|array>">,
+    Xpp::StaticRule<"object", "{<keyValueSeparator*><keyValue>}", "{<space*>}">,
+    Xpp::StaticRule<"array", "\\[<valueSeparator*><value>\\]", "\\[<space*>\\]">,
+    Xpp::StaticRule<"value", "<object|array|integer|real>", "\"<alnum*>\"", "true", "false", "null">,
+    Xpp::StaticRule<"valueSeparator", "<value>,">,
+    Xpp::StaticRule<"keyValue", "\"<alnum*>\" : <value>">,
+    Xpp::StaticRule<"keyValueSeparator", "<keyValue>,">>;
+
+static const char *grammar = R"json({"name": "JSON", "terminals": [], "rules": [
+    {"name": "jsonFile", "expressions": ["<object|array>"]},
+    {"name": "object", "expressions": ["{<keyValueSeparator*><keyValue>}", "{<space*>}"]},
+    {"name": "array", "expressions": ["\\[<valueSeparator*><value>\\]", "\\[<space*>\\]"]},
+    {"name": "value", "expressions": ["<object|array|integer|real>", "\"<alnum*>\"", "true", "false", "null"]},
+    {"name": "valueSeparator", "expressions": ["<value>,"]},
+    {"name": "keyValue", "expressions": ["\"<alnum*>\" : <value>"]},
+    {"name": "keyValueSeparator", "expressions": ["<keyValue>,"]}]})json";
+
+int main(int argc, char **argv)
+{
+    size_t items = Bench::size_argument(argc, argv, 1, 20000);
+    size_t loads = Bench::size_argument(argc, argv, 2, 1000);
+    std::string input = Bench::json_input(items);
+
+    size_t rules = 0;
+    double elapsed = Bench::measure([&]
+                                    {
+                                        for (size_t i = 0; i < loads; i++)
+                                            rules += Xpp::Parser(std::string(grammar)).get_grammar()->get_rules().size();
+                                    });
+    std::printf("%-32s %10.3f us\n", "load the grammar at runtime", elapsed * 1e6 / loads);
+    elapsed = Bench::measure([&]
+                             {
+                                 for (size_t i = 0; i < loads; i++)
+                                 {
+                                     StaticJson parser;
+                                     rules += parser.try_generate_ast("[]").success;
+                                 }
+                             });
+    std::printf("%-32s %10.3f us\n", "construct the static parser", elapsed * 1e6 / loads);
+
+    Xpp::Parser parser{std::string(grammar)};
+    StaticJson static_parser;
+    size_t runtime_nodes = 0;
+    size_t static_nodes = 0;
+    std::printf("input: %zu bytes\n", input.size());
+    elapsed = Bench::measure([&]
+                             { runtime_nodes = parser.generate_ast(std::string_view(input))[0].get_children().size(); });
+    Bench::report("runtime grammar", elapsed, input.size());
+    parser.set_prediction(false);
+    elapsed = Bench::measure([&]
+                             { parser.generate_ast(std::string_view(input)); });
+    Bench::report("runtime grammar, no prediction", elapsed, input.size());
+    elapsed = Bench::measure([&]
+                             { static_nodes = static_parser.generate_ast(std::string_view(input))[0].get_children().size(); });
+    Bench::report("compile-time grammar", elapsed, input.size());
+    std::printf("array items: %zu %zu, %zu\n", runtime_nodes, static_nodes, rules);
+    return 0;
+}
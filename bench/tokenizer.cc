@@ -0,0 +1,86 @@
+/**
+ * @file tokenizer.cc
+ * @author Simone Ancona
+ * @brief Tokenizer throughput: compiled terminal matchers against rebuilding the regex on every match
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+#include "bench.hh"
+
+static const std::string grammar = R"({
+    "name": "bench",
+    "terminals": [
+        {"name": "string", "regex": "\"[^\"]*\""},
+        {"name": "boolean", "regex": "true|false"}
+    ],
+    "rules": [
+        {"name": "file", "expressions": ["<identifier>"]}
+    ]
+})";
+
+static const std::vector<Xpp::TerminalRule> terminals = {
+    {"integer", "[-|+]?\\d+"},
+    {"identifier", "[_a-zA-Z][_a-zA-Z0-9]*"},
+    {"real", "[+|-]?\\d+(\\.\\d+)?"},
+    {"string", "\"[^\"]*\""},
+    {"boolean", "true|false"},
+};
+
+static std::string generate_input(size_t size)
+{
+    static const std::string line = "let value_1 = 42 + 3.14 * \"text\" == true\n";
+    std::string input;
+    input.reserve(size + line.size());
+    while (input.size() < size)
+        input += line;
+    return input;
+}
+
+// The tokenizer as it was before the terminals were compiled: one std::regex per match
+static size_t legacy_tokenize(const std::string &str)
+{
+    size_t count = 0;
+    std::smatch m;
+    for (auto rule : terminals)
+    {
+        std::string::const_iterator s_begin = str.cbegin();
+        while (std::regex_search(s_begin, str.cend(), m, std::regex(rule.regex)))
+        {
+            ++count;
+            s_begin = m.suffix().first;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = Bench::size_argument(argc, argv, 1, 1024 * 1024);
+    std::string input = generate_input(size);
+    std::string legacy_input = input.substr(0, std::min<size_t>(input.size(), 64 * 1024));
+    Xpp::Parser parser(grammar);
+    std::vector<Xpp::Token> tokens;
+    size_t legacy_count = 0;
+
+    std::printf("input: %zu bytes (%zu bytes for the legacy tokenizer)\n", input.size(), legacy_input.size());
+    Bench::report("regex rebuilt on every match", Bench::measure([&]
+                                                                 { legacy_count = legacy_tokenize(legacy_input); }),
+                  legacy_input.size());
+    Bench::report("compiled terminal matchers", Bench::measure([&]
+                                                               { tokens = parser.tokenize(input); }),
+                  input.size());
+    Bench::report("line index", Bench::measure([&]
+                                               {
+                                                   ParserTools::LineIndex lines(input);
+                                                   for (const auto &token : tokens)
+                                                       legacy_count += lines.get_column_line(token.index).second;
+                                               }),
+                  input.size());
+    std::printf("tokens: %zu\n", tokens.size());
+    return 0;
+}
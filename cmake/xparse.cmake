@@ -0,0 +1,28 @@
+# xparse_generate_parser(GRAMMAR <grammar.json> NAME <class name> TARGET <target> [OUTPUT_DIR <directory>])
+#
+# Generates the parser class <class name> from the grammar with xparse-gen at build time and adds it to the
+# target, the target is linked to xparser. The files are regenerated when the grammar or xparse-gen change.
+# OUTPUT_DIR defaults to <target>_xparse in the current binary directory, so every target has its own copy.
+function(xparse_generate_parser)
+    cmake_parse_arguments(XPARSE "" "GRAMMAR;NAME;TARGET;OUTPUT_DIR" "" ${ARGN})
+    if(NOT XPARSE_GRAMMAR OR NOT XPARSE_NAME OR NOT XPARSE_TARGET)
+        message(FATAL_ERROR "xparse_generate_parser requires GRAMMAR, NAME and TARGET")
+    endif()
+    if(NOT XPARSE_OUTPUT_DIR)
+        set(XPARSE_OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/${XPARSE_TARGET}_xparse)
+    endif()
+    get_filename_component(XPARSE_GRAMMAR ${XPARSE_GRAMMAR} ABSOLUTE)
+    file(MAKE_DIRECTORY ${XPARSE_OUTPUT_DIR})
+
+    set(XPARSE_HEADER ${XPARSE_OUTPUT_DIR}/${XPARSE_NAME}.hh)
+    set(XPARSE_SOURCE ${XPARSE_OUTPUT_DIR}/${XPARSE_NAME}.cc)
+    add_custom_command(
+        OUTPUT ${XPARSE_HEADER} ${XPARSE_SOURCE}
+        COMMAND xparse-gen ${XPARSE_GRAMMAR} ${XPARSE_NAME} ${XPARSE_OUTPUT_DIR}
+        DEPENDS xparse-gen ${XPARSE_GRAMMAR}
+        COMMENT "Generating the parser ${XPARSE_NAME} from ${XPARSE_GRAMMAR}"
+        VERBATIM)
+    target_sources(${XPARSE_TARGET} PRIVATE ${XPARSE_HEADER} ${XPARSE_SOURCE})
+    target_include_directories(${XPARSE_TARGET} PRIVATE ${XPARSE_OUTPUT_DIR})
+    target_link_libraries(${XPARSE_TARGET} xparser)
+endfunction()
@@ -11,6 +11,8 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <memory>
 #include <vector>
 #include <stdexcept>
 #include "jpp.hh"
@@ -20,10 +22,26 @@ namespace Xpp
     class AST
     {
     private:
-        std::vector<AST> children;
+        // Copies of a node share its children until one of them changes them, so copying a node does not depend
+        // on the size of its subtree
+        std::shared_ptr<std::vector<AST>> children;
         std::string rule_name;
         bool terminal;
-        std::string value;
+        std::string_view value;
+        std::shared_ptr<const void> source;
+        size_t start = 0;
+        size_t length = 0;
+        size_t lookahead = 0;
+
+        // The children of this node only, copied from the other nodes that share them
+        inline std::vector<AST> &own_children()
+        {
+            if (children == nullptr)
+                children = std::make_shared<std::vector<AST>>();
+            else if (children.use_count() > 1)
+                children = std::make_shared<std::vector<AST>>(*children);
+            return *children;
+        }
 
     public:
         /**
@@ -45,10 +63,23 @@ namespace Xpp
         AST(const std::string &, const std::string &);
 
         /**
-         * @brief Destroy the AST object
+         * @brief Construct a new AST object specifying the rule name and the terminal value as a view of a buffer
+         * that is kept alive by the source, if the source is null the buffer must outlive the node
+         * 
+         */
+        AST(const std::string &, std::string_view, std::shared_ptr<const void>);
+
+        AST(const AST &) = default;
+        AST(AST &&) noexcept = default;
+        AST &operator=(const AST &) = default;
+        AST &operator=(AST &&) noexcept = default;
+
+        /**
+         * @brief Destroy the AST object, the descendants are destroyed without recursion so the depth of the tree
+         * is not limited by the size of the stack
          * 
          */
-        ~AST() = default;
+        ~AST();
 
         /**
          * @brief Check if is an ending node
@@ -72,6 +103,42 @@ namespace Xpp
          */
         std::string get_value();
 
+        /**
+         * @brief Get the terminal value without copying it
+         * 
+         * @return std::string_view 
+         */
+        std::string_view get_value_view();
+
+        /**
+         * @brief Get the offset of the node from the start of its parent, the offset of the root is the offset in
+         * the input
+         * 
+         * @return size_t 
+         */
+        size_t get_start() const noexcept;
+
+        /**
+         * @brief Get the number of bytes of the input covered by the node
+         * 
+         * @return size_t 
+         */
+        size_t get_length() const noexcept;
+
+        /**
+         * @brief Get the number of bytes from the start of the node that were read to match it, it includes the
+         * bytes after the node that decided where it ends
+         * 
+         * @return size_t 
+         */
+        size_t get_lookahead() const noexcept;
+
+        /**
+         * @brief Set the offset, the length and the lookahead of the node
+         * 
+         */
+        void set_span(size_t, size_t, size_t) noexcept;
+
         /**
          * @brief Get the children object
          * 
@@ -103,7 +170,7 @@ namespace Xpp
          */
         inline void push_child(AST node)
         {
-            children.push_back(node);
+            own_children().push_back(std::move(node));
         }
     };
 };
@@ -0,0 +1,64 @@
+/**
+ * @file budget.hh
+ * @author Simone Ancona
+ * @brief Limits of the work of a single parse and cancellation from another thread
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+namespace Xpp
+{
+    /**
+     * @brief A flag shared by the caller and the parsers, the parses that use it fail soon after it is set
+     *
+     */
+    class CancellationToken
+    {
+    private:
+        std::atomic<bool> cancelled = false;
+
+    public:
+        /**
+         * @brief Cancel every parse that uses the token, it can be called from any thread
+         *
+         */
+        inline void cancel() noexcept
+        {
+            cancelled.store(true, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Check if the token was cancelled
+         *
+         * @return true if cancel was called
+         */
+        inline bool is_cancelled() const noexcept
+        {
+            return cancelled.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct ParseBudget
+    {
+        // Maximum number of elements the engine tries to match, 0 means no limit
+        size_t max_steps = 0;
+        // Maximum duration of a parse, including the tokenizer that is not interrupted, 0 means no limit
+        std::chrono::nanoseconds time_limit{0};
+        // Maximum number of AST nodes created, including the ones discarded by backtracking, 0 means no limit
+        size_t max_nodes = 0;
+        // The parse fails once the token is cancelled
+        std::shared_ptr<const CancellationToken> cancellation;
+        // Number of steps between two checks of the time and of the cancellation
+        size_t check_interval = 1024;
+    };
+};
@@ -0,0 +1,179 @@
+/**
+ * @file bytecode.hh
+ * @author Simone Ancona
+ * @brief Grammars compiled to a PEG-style bytecode
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "rel.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Xpp
+{
+    class CompiledGrammar;
+    class ImageWriter;
+    class ImageReader;
+
+    /**
+     * @brief Instructions of the bytecode. An instruction that matches continues with the next one, if it fails
+     * it jumps to its `fail` target
+     *
+     */
+    enum Opcode : uint8_t
+    {
+        // Start the next expression of the rule, at `fail` if the input cannot start it. a: FIRST set
+        OP_PREDICT,
+        // The expression matched, return to the caller of the rule
+        OP_RETURN,
+        // The expression failed, undo it and continue with the next one
+        OP_BACKTRACK,
+        // No expression of the rule matched, return to the caller of the rule
+        OP_NO_EXPRESSION,
+        // Match a constant. a: offset in the text, b: length, c: constant ID
+        OP_STRING,
+        // Match a case-insensitive constant. a: offset of the folded constant in the text, b: length, c: constant ID
+        OP_FOLDED,
+        OP_FOLDED_STRICT,
+        // Match a character class, new lines or the end of the input. a: class, b: repetitions, c: symbol
+        OP_CLASS,
+        OP_NEW_LINE,
+        OP_EOF,
+        // Match a token. a: terminal, c: symbol
+        OP_TOKEN,
+        // Match a rule. a: rule ID
+        OP_CALL,
+        // Start an alternative
+        OP_CHOICE,
+        // Try the next reference of the alternative, at `fail` if the input cannot start it. a: FIRST set
+        OP_ALTERNATIVE,
+        // No reference of the alternative matched
+        OP_NO_ALTERNATIVE,
+        // Continue at a
+        OP_JUMP,
+        // Start a quantified reference, the exact quantifiers also start an attempt of the events
+        OP_MARK,
+        OP_MARK_EXACT,
+        // Go back to where the last repetition ended
+        OP_RESTORE,
+        // Repeat at a if the last repetition moved forward, for '*'
+        OP_AGAIN,
+        // Count the repetition and repeat at a if it moved forward, for '+'
+        OP_AGAIN_COUNT,
+        // End of '+', fails if nothing was repeated. c: symbol
+        OP_AT_LEAST_ONE,
+        // Count the repetition, repeat at a if there were less than b, otherwise continue at c. For '{x}'
+        OP_REPEAT,
+        // End of a failed '{x}'. b: repetitions, c: symbol
+        OP_REPEAT_FAILED,
+        // Count the repetition and repeat at a if there were less than b. For '{x:y}'
+        OP_RANGE,
+        // End of '{x:y}', fails if there were less than b repetitions. c: symbol
+        OP_RANGE_END,
+        // Skip the spaces or check the word boundary between two elements. a: EdgeFlags
+        OP_EDGE,
+    };
+
+    struct Instruction
+    {
+        Opcode op;
+        uint32_t a = 0;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        uint32_t fail = 0;
+    };
+
+    // Minimum and maximum repetitions of an implicit terminal
+    struct Repetitions
+    {
+        size_t min;
+        size_t max;
+    };
+
+    /**
+     * @brief A grammar compiled to bytecode, the instructions of every rule are contiguous and their operands are
+     * indices in the tables of the program
+     *
+     */
+    class Bytecode
+    {
+    private:
+        std::vector<Instruction> code;
+        // The first instruction of every rule by rule ID
+        std::vector<uint32_t> entries;
+        std::vector<FirstSet> first_sets;
+        std::vector<Repetitions> repetitions;
+        // The constants and their folded version
+        std::string text;
+
+        size_t add_first_set(const FirstSet &);
+        size_t add_text(const std::string &);
+        size_t add_repetitions(size_t, size_t);
+        uint32_t emit(Opcode, size_t = 0, size_t = 0, size_t = 0);
+        void patch(std::vector<uint32_t> &, size_t);
+        uint32_t emit_single(const ExpressionReference &);
+        // The instructions that fail to the end of the compiled code are added to the vector
+        void compile_reference(const ExpressionReference &, std::vector<uint32_t> &);
+        void compile_element(const ExpressionElement &, std::vector<uint32_t> &);
+
+    public:
+        Bytecode() = default;
+
+        /**
+         * @brief Compile the rules of a grammar, the references must be resolved
+         *
+         */
+        explicit Bytecode(const CompiledGrammar &);
+
+        inline const std::vector<Instruction> &get_code() const noexcept
+        {
+            return code;
+        }
+
+        inline uint32_t get_entry(size_t rule_id) const noexcept
+        {
+            return entries[rule_id];
+        }
+
+        inline const FirstSet &get_first_set(size_t id) const noexcept
+        {
+            return first_sets[id];
+        }
+
+        inline const Repetitions &get_repetitions(size_t id) const noexcept
+        {
+            return repetitions[id];
+        }
+
+        inline const char *get_text(size_t offset) const noexcept
+        {
+            return text.data() + offset;
+        }
+
+        /**
+         * @brief Get a readable listing of the program, one instruction per line
+         *
+         * @return std::string
+         */
+        std::string dump(const CompiledGrammar &) const;
+
+        /**
+         * @brief Write the program to a binary image of the grammar
+         *
+         */
+        void save(ImageWriter &) const;
+
+        /**
+         * @brief Read the program from a binary image of the grammar
+         *
+         */
+        void load(ImageReader &);
+    };
+};
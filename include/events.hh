@@ -0,0 +1,117 @@
+/**
+ * @file events.hh
+ * @author Simone Ancona
+ * @brief Handlers of the events of a parse that does not build an AST
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "grammar.hh"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Xpp
+{
+    /**
+     * @brief Receives the rules and the terminals matched by the parser, in the order of the input
+     *
+     * The events of an attempt that can still fail are sent between begin and commit or rollback. Attempts are
+     * nested, every begin is followed by exactly one commit or rollback. A rollback undoes every event received
+     * since the matching begin, a commit keeps them as part of the enclosing attempt. The spans are views of the
+     * input.
+     */
+    class EventHandler
+    {
+    public:
+        virtual ~EventHandler() = default;
+
+        /**
+         * @brief A rule starts at the given offset
+         *
+         */
+        virtual void enter_rule(const Rule &, size_t) = 0;
+
+        /**
+         * @brief A rule matched the span, every event since the matching enter_rule belongs to it
+         *
+         */
+        virtual void exit_rule(const Rule &, std::string_view) = 0;
+
+        /**
+         * @brief A terminal matched the span in the rule, like the terminal nodes of the AST
+         *
+         */
+        virtual void terminal(const Rule &, std::string_view) = 0;
+
+        /**
+         * @brief An attempt starts
+         *
+         */
+        virtual void begin() = 0;
+
+        /**
+         * @brief The last attempt matched
+         *
+         */
+        virtual void commit() = 0;
+
+        /**
+         * @brief The last attempt failed, its events must be undone
+         *
+         */
+        virtual void rollback() = 0;
+    };
+
+    /**
+     * @brief Keeps the events of the attempts until no attempt can undo them, then sends them to another handler
+     * that never receives begin, commit or rollback
+     *
+     * The events are forwarded as soon as the outermost attempt commits. An attempt that spans the whole input,
+     * like a top rule with more than one expression, keeps every event until the end of the parse.
+     */
+    class EventBuffer : public EventHandler
+    {
+    private:
+        enum EventKind : uint8_t
+        {
+            EVENT_ENTER,
+            EVENT_EXIT,
+            EVENT_TERMINAL
+        };
+
+        struct Event
+        {
+            EventKind kind;
+            const Rule *rule;
+            std::string_view span;
+            size_t offset;
+        };
+
+        EventHandler &target;
+        std::vector<Event> events;
+        // The number of buffered events when every open attempt started
+        std::vector<size_t> attempts;
+
+        void forward(const Event &);
+
+    public:
+        /**
+         * @brief Construct a new EventBuffer object that forwards the events to the handler
+         *
+         */
+        EventBuffer(EventHandler &);
+
+        void enter_rule(const Rule &, size_t) override;
+        void exit_rule(const Rule &, std::string_view) override;
+        void terminal(const Rule &, std::string_view) override;
+        void begin() override;
+        void commit() override;
+        void rollback() override;
+    };
+};
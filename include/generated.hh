@@ -0,0 +1,337 @@
+/**
+ * @file generated.hh
+ * @author Simone Ancona
+ * @brief Runtime of the parsers generated by xparse-gen
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "xparser.hh"
+#include <cstring>
+
+namespace Xpp
+{
+    /**
+     * @brief FIRST set of an expression or a reference of a generated parser, the terminals are a bit set of
+     * `Words` words
+     *
+     */
+    template <size_t Words>
+    struct GeneratedFirstSet
+    {
+        uint64_t bytes[4];
+        bool end;
+        bool tokens_only;
+        uint64_t terminals[Words];
+    };
+
+    /**
+     * @brief Base of the parsers generated by xparse-gen, every rule of the grammar is a function of the derived
+     * class and this class keeps the state of a parse
+     *
+     * The generated functions match the input exactly like the recursive engine of Parser with predictive parsing,
+     * so the AST is the same and syntax errors are reported at the same offset with the same message.
+     */
+    class GeneratedParser
+    {
+    private:
+        struct GeneratedFailure
+        {
+            FailureKind kind;
+            const std::string *rule;
+            // The constant or the name of the reference
+            const char *text;
+            size_t count;
+            size_t offset;
+        };
+
+        Lexer lexer;
+        std::string root;
+        bool failed = false;
+        GeneratedFailure farthest;
+        size_t last_failure_offset = 0;
+
+        SyntaxError describe_failure(const GeneratedFailure &) const;
+        ParseResult parse(std::shared_ptr<const Source>, std::string_view);
+
+    protected:
+        std::shared_ptr<const Source> source;
+        std::string_view input;
+        std::vector<Token> tokens;
+        ParserTools::LineIndex lines;
+        Index index;
+
+        /**
+         * @brief Construct a new GeneratedParser object with the terminals of the grammar, in the order of the
+         * compiled grammar, and the name of the first rule
+         *
+         */
+        GeneratedParser(const std::vector<TerminalRule> &, const std::string &);
+
+        /**
+         * @brief Match the first rule of the grammar, implemented by the generated parser
+         *
+         */
+        virtual bool parse_root(AST &) = 0;
+
+        /**
+         * @brief Record a failure at the current offset
+         *
+         */
+        inline void fail(FailureKind kind, const std::string &rule, const char *text, size_t count = 0) noexcept
+        {
+            fail_at(kind, rule, text, count, index.char_index);
+        }
+
+        inline void fail_at(FailureKind kind, const std::string &rule, const char *text, size_t count, size_t offset) noexcept
+        {
+            last_failure_offset = offset;
+            if (!failed || offset >= farthest.offset)
+                farthest = {kind, &rule, text, count, offset};
+            failed = true;
+        }
+
+        inline bool has_failed() const noexcept
+        {
+            return failed;
+        }
+
+        template <size_t Words>
+        inline bool viable(const GeneratedFirstSet<Words> &set) const noexcept
+        {
+            size_t char_index = index.char_index;
+            if (char_index >= input.length())
+                return set.end;
+            unsigned char byte = static_cast<unsigned char>(input[char_index]);
+            if (!((set.bytes[byte >> 6] >> (byte & 63)) & 1))
+                return false;
+            if (!set.tokens_only)
+                return true;
+            if (index.token_index >= tokens.size() || tokens[index.token_index].index != char_index)
+                return false;
+            uint32_t terminal = tokens[index.token_index].terminal;
+            return terminal < Words * 64 && ((set.terminals[terminal >> 6] >> (terminal & 63)) & 1);
+        }
+
+        inline void advance_to(size_t char_index) noexcept
+        {
+            index.char_index = char_index;
+            while (index.token_index < tokens.size() && tokens[index.token_index].index < char_index)
+                index.token_index++;
+        }
+
+        inline void backtrack(AST &ast, Index start, size_t children)
+        {
+            index = start;
+            ast.get_children().resize(children);
+        }
+
+        inline void attach(AST &ast, AST child)
+        {
+            child.set_span(child.get_start() - ast.get_start(), child.get_length(), child.get_lookahead());
+            ast.push_child(std::move(child));
+        }
+
+        inline void terminal_node(AST &ast, const std::string &rule, size_t char_index, size_t length)
+        {
+            AST node(rule, input.substr(char_index, length), source);
+            node.set_span(char_index, length, length);
+            attach(ast, std::move(node));
+        }
+
+        inline bool constant(AST &ast, const std::string &rule, const char *value, size_t length)
+        {
+            size_t char_index = index.char_index;
+            if (input.length() - char_index < length || std::memcmp(input.data() + char_index, value, length) != 0)
+            {
+                std::string_view next = input.substr(char_index, length);
+                size_t i = std::mismatch(next.begin(), next.end(), value).first - next.begin();
+                fail(FAILURE_CONSTANT, rule, value, i);
+                return false;
+            }
+            advance_to(char_index + length);
+            terminal_node(ast, rule, char_index, length);
+            return true;
+        }
+
+        bool folded_constant(AST &, const std::string &, const char *, const char *, size_t, bool);
+
+        // Between the elements of an expression with the 's' flag
+        inline void skip_spaces() noexcept
+        {
+            size_t char_index = index.char_index;
+            size_t length = Scanner::scan(CLASS_SPACE, input.data() + char_index, input.length() - char_index);
+            if (length != 0)
+                advance_to(char_index + length);
+        }
+
+        // Between the elements of an expression with the 'b' flag, the expression started at `start`
+        inline bool boundary(const std::string &rule, size_t start) noexcept
+        {
+            size_t char_index = index.char_index;
+            if (char_index == start || char_index >= input.length() || !Scanner::is_in_class(CLASS_IDENTIFIER, input[char_index - 1]) ||
+                !Scanner::is_in_class(CLASS_IDENTIFIER, input[char_index]))
+                return true;
+            fail(FAILURE_BOUNDARY, rule, nullptr);
+            return false;
+        }
+
+        inline bool token(AST &ast, const std::string &rule, uint32_t terminal, const char *symbol)
+        {
+            const Token *next = index.token_index < tokens.size() ? &tokens[index.token_index] : nullptr;
+            if (next != nullptr && next->index == index.char_index && next->terminal == terminal)
+            {
+                terminal_node(ast, rule, next->index, next->length);
+                index = {index.token_index + 1, next->index + next->length};
+                return true;
+            }
+            fail(FAILURE_REFERENCE, rule, symbol);
+            return false;
+        }
+
+        bool implicit_terminal(AST &, const std::string &, ReferenceKind, size_t, size_t, size_t, const char *);
+
+        inline void rule_matched(AST &ast, AST child, Index start)
+        {
+            child.set_span(start.char_index, index.char_index - start.char_index, 0);
+            attach(ast, std::move(child));
+        }
+
+        inline void rule_failed(const std::string &target, Index start)
+        {
+            fail_at(FAILURE_RULE, target, nullptr, 0, last_failure_offset);
+            index = start;
+        }
+
+        template <typename F>
+        inline bool zero_or_one(F &&single)
+        {
+            Index last_index = index;
+            if (!single())
+                index = last_index;
+            return true;
+        }
+
+        template <typename F>
+        inline bool zero_or_more(F &&single)
+        {
+            Index last_index = index;
+            while (single() && index.char_index != last_index.char_index)
+                last_index = index;
+            index = last_index;
+            return true;
+        }
+
+        template <typename F>
+        inline bool one_or_more(F &&single, const std::string &rule, const char *symbol)
+        {
+            Index last_index = index;
+            bool error = true;
+            while (single())
+            {
+                error = false;
+                if (index.char_index == last_index.char_index)
+                    break;
+                last_index = index;
+            }
+            index = last_index;
+            if (error)
+            {
+                fail(FAILURE_ONE_OR_MORE, rule, symbol);
+                return false;
+            }
+            return true;
+        }
+
+        template <typename F>
+        inline bool exact_value(AST &ast, F &&single, size_t x, const std::string &rule, const char *symbol)
+        {
+            Index last_index = index;
+            size_t children = ast.get_children().size();
+            for (size_t i = 0; i < x; i++)
+            {
+                if (!single())
+                {
+                    backtrack(ast, last_index, children);
+                    fail(FAILURE_EXACT_VALUE, rule, symbol, x);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename F>
+        inline bool exact_range(AST &ast, F &&single, size_t x, size_t y, const std::string &rule, const char *symbol)
+        {
+            Index start_index = index;
+            Index last_index = index;
+            size_t children = ast.get_children().size();
+            size_t i = 0;
+            while (i < y && single())
+            {
+                last_index = index;
+                i++;
+            }
+            index = last_index;
+            if (i < x)
+            {
+                backtrack(ast, start_index, children);
+                fail(FAILURE_EXACT_RANGE, rule, symbol, x);
+                return false;
+            }
+            return true;
+        }
+
+    public:
+        virtual ~GeneratedParser() = default;
+
+        /**
+         * @brief Get the ast object
+         *
+         * @return AST
+         */
+        AST generate_ast(const std::string &);
+
+        /**
+         * @brief Get the ast object parsing the buffer in place, the values of the AST refer to the buffer so it
+         * must outlive the AST
+         *
+         * @return AST
+         */
+        AST generate_ast(std::string_view);
+
+        /**
+         * @brief Get the ast object
+         *
+         * @return AST
+         */
+        AST generate_ast(const char *);
+
+        /**
+         * @brief Get the ast object without throwing on syntax errors
+         *
+         * @return ParseResult
+         */
+        ParseResult try_generate_ast(const std::string &);
+
+        /**
+         * @brief Get the ast object parsing the buffer in place without throwing on syntax errors, the values of
+         * the AST refer to the buffer so it must outlive the AST
+         *
+         * @return ParseResult
+         */
+        ParseResult try_generate_ast(std::string_view);
+
+        /**
+         * @brief Get the ast object without throwing on syntax errors
+         *
+         * @return ParseResult
+         */
+        ParseResult try_generate_ast(const char *);
+    };
+};
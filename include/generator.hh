@@ -0,0 +1,73 @@
+/**
+ * @file generator.hh
+ * @author Simone Ancona
+ * @brief Generator of C++ parsers specialized for a grammar
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "grammar.hh"
+#include <string>
+#include <vector>
+
+namespace Xpp
+{
+    /**
+     * @brief Writes the C++ source of a parser for a compiled grammar, the parser derives from GeneratedParser
+     *
+     * Every rule becomes a function that tries its expressions in order, every expression a function that
+     * matches its elements, constants are compared inline and references call the function of the rule
+     * directly. The FIRST sets are written as tables, so the generated parser predicts like Parser does.
+     */
+    class CodeGenerator
+    {
+    private:
+        const CompiledGrammar &grammar;
+        std::string class_name;
+        // Initializers of the FIRST set tables, the index is the number in the name of the table
+        std::vector<std::string> first_sets;
+
+        size_t terminal_words() const noexcept;
+        std::string add_first_set(const FirstSet &);
+        std::string viability(const FirstSet &);
+        std::string reference(const ExpressionReference &, size_t);
+        std::string element(const ExpressionElement &, size_t);
+        // The code of the EdgeFlags before an element or after the last one
+        std::string edge(int, size_t);
+        std::string rule_function(size_t);
+        std::string expression_function(size_t, size_t);
+
+    public:
+        /**
+         * @brief Construct a new CodeGenerator object for the grammar, the parser is a class with the given name
+         *
+         */
+        CodeGenerator(const CompiledGrammar &, const std::string &);
+
+        /**
+         * @brief Get the header that declares the parser class
+         *
+         * @return std::string
+         */
+        std::string generate_header();
+
+        /**
+         * @brief Get the source that defines the parser class, it includes the header with the given name
+         *
+         * @return std::string
+         */
+        std::string generate_source(const std::string &);
+
+        /**
+         * @brief Get a C++ string literal with the given value
+         *
+         * @return std::string
+         */
+        static std::string literal(const std::string &);
+    };
+};
@@ -0,0 +1,178 @@
+/**
+ * @file grammar.hh
+ * @author Simone Ancona
+ * @brief Grammar compiled once and shared by every parser that uses it
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "jpp.hh"
+#include "rel.hh"
+#include "lexer.hh"
+#include "scanner.hh"
+#include "bytecode.hh"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+namespace Xpp
+{
+    struct Rule
+    {
+        std::string name;
+        std::vector<RuleExpression> expressions;
+    };
+
+    /**
+     * @brief The rules, the terminals and every table derived from them
+     *
+     * A compiled grammar is never modified after it is constructed, so a single instance can be shared through a
+     * std::shared_ptr by parsers running on different threads without any lock. The state of a parse lives in the
+     * parser.
+     */
+    class CompiledGrammar
+    {
+    private:
+        Jpp::Json grammar;
+        std::vector<Rule> rules;
+        std::vector<TerminalRule> terminals = {{"integer", "[-+]?\\d+"}, {"identifier", "[_a-zA-Z][_a-zA-Z0-9]*"}, {"real", "[-+]?\\d+(\\.\\d+)?"}};
+        Lexer lexer;
+        ConstantTable constants;
+        std::vector<FirstSet> rule_first_sets;
+        std::vector<std::string> symbols;
+        Bytecode bytecode;
+
+        void generate_from_json();
+        void generate_terminal_rules(const std::map<std::string, Jpp::Json> &);
+        void compile_terminal_rules();
+        void compile_constants();
+        void compute_first_sets();
+        FirstSet expression_first_set(RuleExpression &);
+        FirstSet reference_first_set(ExpressionReference &);
+        void generate_rules(const std::map<std::string, Jpp::Json> &);
+        std::vector<Jpp::Json> get_array_elements(const std::map<std::string, Jpp::Json> &);
+        std::vector<RuleExpression> parse_expressions(const std::map<std::string, Jpp::Json> &);
+        void resolve_reference(ExpressionReference &, const std::string &);
+        Rule *find_rule(const std::string &);
+        TerminalRule *find_terminal_rule(const std::string &);
+        std::string get_string_from_file(const std::ifstream &);
+        size_t get_symbol(const std::string &);
+
+        CompiledGrammar() = default;
+
+    public:
+        /**
+         * @brief Compile a grammar from a JSON object
+         *
+         */
+        CompiledGrammar(const Jpp::Json &);
+
+        /**
+         * @brief Compile a grammar from a JSON string
+         *
+         */
+        CompiledGrammar(const std::string &);
+
+        /**
+         * @brief Compile a grammar from an input file stream
+         *
+         */
+        CompiledGrammar(const std::ifstream &);
+
+        ~CompiledGrammar() = default;
+
+        /**
+         * @brief Get the rules, the ID of a rule is its position and the first one is the start rule
+         *
+         * @return const std::vector<Rule>&
+         */
+        inline const std::vector<Rule> &get_rules() const noexcept
+        {
+            return rules;
+        }
+
+        /**
+         * @brief Get the terminal rules in order of priority
+         *
+         * @return const std::vector<TerminalRule>&
+         */
+        inline const std::vector<TerminalRule> &get_terminals() const noexcept
+        {
+            return terminals;
+        }
+
+        /**
+         * @brief Get the tokenizer of the terminal rules
+         *
+         * @return const Lexer&
+         */
+        inline const Lexer &get_lexer() const noexcept
+        {
+            return lexer;
+        }
+
+        /**
+         * @brief Get the trie of the constant terminals
+         *
+         * @return const ConstantTable&
+         */
+        inline const ConstantTable &get_constants() const noexcept
+        {
+            return constants;
+        }
+
+        /**
+         * @brief Get the names of the references, used in error messages
+         *
+         * @return const std::vector<std::string>&
+         */
+        inline const std::vector<std::string> &get_symbols() const noexcept
+        {
+            return symbols;
+        }
+
+        /**
+         * @brief Get the FIRST set of every rule by rule ID
+         *
+         * @return const std::vector<FirstSet>&
+         */
+        inline const std::vector<FirstSet> &get_rule_first_sets() const noexcept
+        {
+            return rule_first_sets;
+        }
+
+        /**
+         * @brief Get the rules compiled to bytecode
+         *
+         * @return const Bytecode&
+         */
+        inline const Bytecode &get_bytecode() const noexcept
+        {
+            return bytecode;
+        }
+
+        /**
+         * @brief Save the compiled grammar to a binary image, a versioned and checksummed file that holds the
+         * resolved rules, the terminals, the constant table, the FIRST sets and the bytecode
+         *
+         */
+        void save(const std::string &) const;
+
+        /**
+         * @brief Load a compiled grammar from a binary image saved by `save`, the file is mapped in memory and no
+         * JSON or rule expression is parsed. Images of another version or damaged ones throw std::runtime_error
+         *
+         * @return std::shared_ptr<const CompiledGrammar>
+         */
+        static std::shared_ptr<const CompiledGrammar> load(const std::string &);
+    };
+};
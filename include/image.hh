@@ -0,0 +1,170 @@
+/**
+ * @file image.hh
+ * @author Simone Ancona
+ * @brief Binary image of a compiled grammar
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "rel.hh"
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Xpp
+{
+    // Bumped whenever the layout of the image changes, images of other versions are rejected
+    constexpr uint32_t IMAGE_VERSION = 2;
+
+    /**
+     * @brief The header in front of the payload of an image. The payload is written in the byte order and with the
+     * sizes of the machine that saved it, so the marker rejects images saved by a different kind of machine
+     *
+     */
+    struct ImageHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t marker;
+        uint64_t length;
+        uint64_t checksum;
+    };
+
+    constexpr char IMAGE_MAGIC[8] = {'X', 'P', 'A', 'R', 'S', 'E', 'R', 'G'};
+    constexpr uint32_t IMAGE_MARKER = 0x01020300 | sizeof(size_t);
+
+    /**
+     * @brief Appends the values of a compiled grammar to the payload of an image
+     *
+     */
+    class ImageWriter
+    {
+    private:
+        std::string payload;
+
+    public:
+        // Numbers are written as they are, classes write themselves with a save method
+        template <typename T>
+        void write(const T &value)
+        {
+            if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+                payload.append(reinterpret_cast<const char *>(&value), sizeof(T));
+            else
+                value.save(*this);
+        }
+
+        void write(const std::string &);
+        void write(const std::bitset<256> &);
+        void write(const FirstSet &);
+
+        template <typename T>
+        void write(const std::vector<T> &values)
+        {
+            write<uint64_t>(values.size());
+            if constexpr (std::is_arithmetic_v<T>)
+                payload.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+            else
+            {
+                for (const T &value : values)
+                    write(value);
+            }
+        }
+
+        /**
+         * @brief Get the header followed by the payload
+         *
+         * @return std::string
+         */
+        std::string get_image() const;
+    };
+
+    /**
+     * @brief Reads the values of a compiled grammar from the payload of an image, in the order they were written
+     *
+     */
+    class ImageReader
+    {
+    private:
+        const char *data;
+        size_t length;
+        size_t offset = 0;
+
+        const char *take(size_t);
+
+    public:
+        /**
+         * @brief Check the header of an image and read its payload, the image must outlive the reader
+         *
+         */
+        explicit ImageReader(std::string_view);
+
+        template <typename T>
+        void read(T &value)
+        {
+            if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+                std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            else
+                value.load(*this);
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            read(value);
+            return value;
+        }
+
+        void read(std::string &);
+        void read(std::bitset<256> &);
+        void read(FirstSet &);
+
+        /**
+         * @brief Read the number of elements of a sequence. Every element takes at least a byte, so a wrong count
+         * cannot allocate more than the payload
+         *
+         * @return size_t
+         */
+        size_t read_count();
+
+        template <typename T>
+        void read(std::vector<T> &values)
+        {
+            size_t size = read_count();
+            if constexpr (std::is_arithmetic_v<T>)
+            {
+                if (size > (length - offset) / sizeof(T))
+                    throw std::runtime_error("The compiled grammar is truncated");
+                const char *bytes = take(size * sizeof(T));
+                values.resize(size);
+                std::memcpy(values.data(), bytes, size * sizeof(T));
+            }
+            else
+            {
+                values.resize(size);
+                for (T &value : values)
+                    read(value);
+            }
+        }
+
+        /**
+         * @brief Check that the whole payload was read
+         *
+         * @return true
+         * @return false
+         */
+        inline bool at_end() const noexcept
+        {
+            return offset == length;
+        }
+    };
+};
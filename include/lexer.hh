@@ -0,0 +1,312 @@
+/**
+ * @file lexer.hh
+ * @author Simone Ancona
+ * @brief Terminal matchers and the tokenizer
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <regex>
+#include <vector>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include "scanner.hh"
+#include "thread_pool.hh"
+
+namespace Xpp
+{
+    class ImageWriter;
+    class ImageReader;
+
+    struct TerminalRule
+    {
+        std::string name;
+        std::string regex;
+    };
+
+    /**
+     * @brief A span of the input matched by a terminal, the input must outlive the token
+     *
+     */
+    struct Token
+    {
+        uint32_t terminal;
+        uint32_t length;
+        size_t index;
+
+        /**
+         * @brief Get the matched characters
+         *
+         * @return std::string_view
+         */
+        inline std::string_view get_value(std::string_view input) const noexcept
+        {
+            return input.substr(index, length);
+        }
+    };
+
+    /**
+     * @brief A terminal rule compiled once into a reusable matcher
+     *
+     * Terminals whose regular expression is one of the predefined ones are matched by a hand-written scanner instead
+     * of std::regex.
+     */
+    class TerminalMatcher
+    {
+    private:
+        TerminalRule rule;
+        std::regex regex;
+        size_t (*scanner)(const char *, size_t) noexcept = nullptr;
+        std::bitset<256> first_bytes;
+
+        void compile();
+
+    public:
+        /**
+         * @brief Compile the regular expression of a terminal rule
+         *
+         */
+        TerminalMatcher(const TerminalRule &);
+
+        /**
+         * @brief Compile the regular expression of a terminal rule whose first bytes are already known
+         *
+         */
+        TerminalMatcher(const TerminalRule &, const std::bitset<256> &);
+
+        ~TerminalMatcher() = default;
+
+        /**
+         * @brief Match the terminal exactly at the given offset
+         *
+         * @return size_t the length of the match, 0 if there is no match
+         */
+        size_t match(std::string_view, size_t, std::cmatch &) const;
+
+        /**
+         * @brief Match the terminal exactly at the given offset and set the end of the input that was read to
+         * decide the match, including the bytes after the match
+         *
+         * @return size_t the length of the match, 0 if there is no match
+         */
+        size_t match(std::string_view, size_t, size_t &) const;
+
+        /**
+         * @brief Get the terminal rule this matcher was compiled from
+         *
+         * @return const TerminalRule&
+         */
+        const TerminalRule &get_rule() const noexcept;
+
+        /**
+         * @brief Get the set of bytes a non-empty match can start with
+         *
+         * @return const std::bitset<256>&
+         */
+        const std::bitset<256> &get_first_bytes() const noexcept;
+    };
+
+    struct TokenizerOptions
+    {
+        // Number of threads used to tokenize, 1 tokenizes on the calling thread and 0 uses every hardware thread
+        size_t threads = 1;
+        // Inputs are split in chunks of about this size, each chunk is tokenized by a single thread
+        size_t chunk_size = 1 << 20;
+    };
+
+    /**
+     * @brief Single pass longest-match tokenizer
+     *
+     * At each offset only the terminals that can start with the current byte are tried, the longest match wins and
+     * ties are resolved in favour of the terminal that comes first. Bytes that no terminal matches are skipped, so
+     * the resulting tokens never overlap and are already sorted by offset.
+     */
+    class Lexer
+    {
+    private:
+        std::vector<TerminalMatcher> matchers;
+        std::array<std::vector<size_t>, 256> candidates;
+
+        void index_candidates();
+        size_t match(std::string_view, size_t, size_t &, std::cmatch &) const;
+        size_t match(std::string_view, size_t, size_t &, size_t &) const;
+        void tokenize(std::string_view, size_t, size_t, std::vector<Token> &) const;
+
+    public:
+        Lexer() = default;
+
+        /**
+         * @brief Construct a new Lexer object from the terminal rules in order of priority
+         *
+         */
+        Lexer(const std::vector<TerminalRule> &);
+
+        ~Lexer() = default;
+
+        /**
+         * @brief Split the input string into non-overlapping tokens, the terminal of a token is its position in the
+         * list of terminal rules
+         *
+         * @return std::vector<Token>
+         */
+        std::vector<Token> tokenize(std::string_view) const;
+
+        /**
+         * @brief Split the input string into non-overlapping tokens, replacing the content of the vector so its
+         * memory is reused
+         *
+         */
+        void tokenize(std::string_view, std::vector<Token> &) const;
+
+        /**
+         * @brief Split the input string into non-overlapping tokens and record how far the input was read to find
+         * them. The n-th read is the end of the input read from the end of the token n - 1 to the end of the token
+         * n, the last one is for the bytes after the last token
+         *
+         */
+        void tokenize(std::string_view, std::vector<Token> &, std::vector<size_t> &) const;
+
+        /**
+         * @brief Update the tokens and the reads of the previous input after the bytes in [offset, offset + removed)
+         * were replaced by `inserted` bytes, the string is the new input
+         *
+         * Only the tokens found by reading the edited bytes are tokenized again, and the tokenizer stops as soon as
+         * it reaches a previous token after the edit, because from there the tokens are the same shifted by the
+         * difference in length.
+         *
+         * @return std::pair<size_t, size_t> the range of the new input that was tokenized again
+         */
+        std::pair<size_t, size_t> retokenize(std::string_view, std::vector<Token> &, std::vector<size_t> &, size_t, size_t, size_t) const;
+
+        /**
+         * @brief Split the input string into non-overlapping tokens using a thread pool
+         *
+         * The input is split in chunks at the first new line after every `chunk_size` bytes and each chunk is
+         * tokenized on its own. A chunk is tokenized as if the input started there, so when a token of the previous
+         * chunk crosses the boundary the beginning of the chunk is tokenized again until it agrees with the
+         * sequential tokenizer. The result is always the same as the sequential one.
+         *
+         * @return std::vector<Token>
+         */
+        std::vector<Token> tokenize(std::string_view, ThreadPool &, size_t) const;
+
+        /**
+         * @brief Get the compiled matchers in order of priority
+         *
+         * @return const std::vector<TerminalMatcher>&
+         */
+        const std::vector<TerminalMatcher> &get_matchers() const noexcept;
+
+        /**
+         * @brief Write the first bytes of every matcher to a binary image of the grammar
+         *
+         */
+        void save(ImageWriter &) const;
+
+        /**
+         * @brief Compile the matchers of the terminal rules with the first bytes read from a binary image of the
+         * grammar. Regular expressions cannot be stored, so the ones without a scanner are compiled again
+         *
+         */
+        void load(ImageReader &, const std::vector<TerminalRule> &);
+    };
+
+    /**
+     * @brief Trie of every constant terminal of a grammar
+     *
+     * A probe walks the trie once from an offset of the input and records the path, then checking whether any
+     * constant starts at that offset is a single comparison with the node of the constant at its depth. The
+     * transitions of the root are a 256 entries table, so a byte that no constant starts with is rejected at once.
+     */
+    class ConstantTable
+    {
+    private:
+        struct Node
+        {
+            uint32_t first_edge;
+            uint32_t edge_count;
+        };
+
+        struct Edge
+        {
+            unsigned char byte;
+            uint32_t target;
+        };
+
+        std::vector<std::string> constants;
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+        std::array<int32_t, 256> root;
+        std::vector<uint32_t> constant_nodes;
+
+    public:
+        ConstantTable() = default;
+        ~ConstantTable() = default;
+
+        /**
+         * @brief Add a constant, adding the same constant twice returns the same ID
+         *
+         * @return size_t the ID of the constant
+         */
+        size_t add(std::string_view);
+
+        /**
+         * @brief Build the trie once every constant was added
+         *
+         */
+        void build();
+
+        /**
+         * @brief Walk the trie from an offset of the input, the path starts with the root
+         *
+         */
+        void probe(std::string_view, size_t, std::vector<uint32_t> &) const;
+
+        /**
+         * @brief Check if a constant starts at the offset of a probe
+         *
+         * @return true
+         * @return false
+         */
+        inline bool matches(const std::vector<uint32_t> &path, size_t id) const noexcept
+        {
+            size_t depth = constants[id].length();
+            return depth < path.size() && path[depth] == constant_nodes[id];
+        }
+
+        /**
+         * @brief Get a constant from its ID
+         *
+         * @return const std::string&
+         */
+        const std::string &get_constant(size_t) const;
+
+        /**
+         * @brief Get the number of constants
+         *
+         * @return size_t
+         */
+        size_t size() const noexcept;
+
+        /**
+         * @brief Write the constants and the trie to a binary image of the grammar
+         *
+         */
+        void save(ImageWriter &) const;
+
+        /**
+         * @brief Read the constants and the trie from a binary image of the grammar, no trie is built again
+         *
+         */
+        void load(ImageReader &);
+    };
+};
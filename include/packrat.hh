@@ -0,0 +1,138 @@
+/**
+ * @file packrat.hh
+ * @author Simone Ancona
+ * @brief Bounded cache of the results of rules for packrat parsing
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+namespace Xpp
+{
+    struct PackratOptions
+    {
+        // Cache the result of every rule at every position, so a rule is never matched twice at the same offset
+        bool enabled = false;
+        // Maximum number of cached results, the least recently used result is dropped first and 0 means no limit
+        size_t max_entries = 1 << 16;
+    };
+
+    /**
+     * @brief Least recently used cache of results keyed by rule ID and input offset
+     *
+     * @tparam Value the cached result
+     */
+    template <typename Value>
+    class PackratCache
+    {
+    private:
+        struct Key
+        {
+            size_t rule;
+            size_t position;
+
+            inline bool operator==(const Key &other) const noexcept
+            {
+                return rule == other.rule && position == other.position;
+            }
+        };
+
+        struct KeyHash
+        {
+            inline size_t operator()(const Key &key) const noexcept
+            {
+                return std::hash<size_t>()(key.position * 0x9E3779B97F4A7C15ull ^ key.rule);
+            }
+        };
+
+        using Entries = std::list<std::pair<Key, Value>>;
+
+        Entries entries;
+        std::unordered_map<Key, typename Entries::iterator, KeyHash> index;
+        size_t capacity = 0;
+
+    public:
+        PackratCache() = default;
+        ~PackratCache() = default;
+
+        /**
+         * @brief Set the maximum number of results, 0 means no limit
+         *
+         */
+        inline void set_capacity(size_t max_entries)
+        {
+            capacity = max_entries;
+            while (capacity != 0 && entries.size() > capacity)
+            {
+                index.erase(entries.back().first);
+                entries.pop_back();
+            }
+        }
+
+        /**
+         * @brief Get the result of a rule at an offset and mark it as the most recently used
+         *
+         * @return const Value* nullptr if the result is not cached
+         */
+        inline const Value *find(size_t rule, size_t position)
+        {
+            auto found = index.find(Key{rule, position});
+            if (found == index.end())
+                return nullptr;
+            entries.splice(entries.begin(), entries, found->second);
+            return &found->second->second;
+        }
+
+        /**
+         * @brief Cache the result of a rule at an offset
+         *
+         */
+        inline void insert(size_t rule, size_t position, Value value)
+        {
+            Key key{rule, position};
+            auto found = index.find(key);
+            if (found != index.end())
+            {
+                found->second->second = std::move(value);
+                entries.splice(entries.begin(), entries, found->second);
+                return;
+            }
+            if (capacity != 0 && entries.size() == capacity)
+            {
+                index.erase(entries.back().first);
+                entries.pop_back();
+            }
+            entries.emplace_front(key, std::move(value));
+            index.emplace(key, entries.begin());
+        }
+
+        /**
+         * @brief Drop every result
+         *
+         */
+        inline void clear() noexcept
+        {
+            entries.clear();
+            index.clear();
+        }
+
+        /**
+         * @brief Get the number of cached results
+         *
+         * @return size_t
+         */
+        inline size_t size() const noexcept
+        {
+            return entries.size();
+        }
+    };
+};
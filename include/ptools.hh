@@ -10,9 +10,55 @@
  */
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
 #pragma once
 
 namespace ParserTools
 {
     char get_next(std::string, size_t&) noexcept;
-};
\ No newline at end of file
+
+    /**
+     * @brief Offsets of the beginning of every line of a string, built once so that the line and the column of an
+     * offset can be found with a binary search
+     * 
+     */
+    class LineIndex
+    {
+    private:
+        std::vector<size_t> line_starts = {0};
+        size_t length = 0;
+
+    public:
+        LineIndex() = default;
+
+        /**
+         * @brief Construct a new LineIndex object scanning the string for new lines
+         * 
+         */
+        LineIndex(std::string_view);
+
+        ~LineIndex() = default;
+
+        /**
+         * @brief Scan another string for new lines, the memory of the previous one is reused
+         * 
+         */
+        void assign(std::string_view);
+
+        /**
+         * @brief Get the column and the line (both starting from 0) of an offset
+         * 
+         * @return std::pair<size_t, size_t> 
+         */
+        std::pair<size_t, size_t> get_column_line(size_t) const noexcept;
+
+        /**
+         * @brief Get the number of lines
+         * 
+         * @return size_t 
+         */
+        size_t get_line_count() const noexcept;
+    };
+};
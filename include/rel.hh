@@ -11,8 +11,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <bitset>
 #include <stdexcept>
 #include "ptools.hh"
 
@@ -22,6 +25,9 @@
 
 namespace Xpp
 {
+    class ImageWriter;
+    class ImageReader;
+
     enum ExpressionElementType
     {
         CONSTANT_TERMINAL,
@@ -46,10 +52,61 @@ namespace Xpp
         size_t y_value;
     };
 
+    enum ReferenceKind
+    {
+        REFERENCE_RULE,
+        REFERENCE_TERMINAL,
+        REFERENCE_CLASS,
+        REFERENCE_NEW_LINE,
+        REFERENCE_EOF
+    };
+
+    // What is done between two elements of an expression, from its 's' and 'b' flags
+    enum EdgeFlags
+    {
+        EDGE_NONE = 0,
+        // Skip the spaces before the element
+        EDGE_SKIP_SPACES = 1,
+        // The element cannot start inside the word where the previous one ended
+        EDGE_BOUNDARY = 2
+    };
+
+    /**
+     * @brief What the input can start with for an element, an expression or a rule to match
+     *
+     */
+    struct FirstSet
+    {
+        // Bytes a non-empty match can start with
+        std::bitset<256> bytes;
+        // If every non-empty match starts with a token, the terminal IDs of those tokens
+        std::vector<bool> terminals;
+        bool tokens_only = false;
+        // The match can be empty, so it cannot be predicted from the input
+        bool nullable = false;
+        // The match can happen at the end of the input
+        bool end = false;
+
+        /**
+         * @brief Add the elements of another set
+         *
+         */
+        void merge(const FirstSet &);
+
+        bool operator==(const FirstSet &) const = default;
+    };
+
     struct ExpressionReference
     {
         std::string reference_to;
         Quantifier quantifier;
+        // Resolved when the grammar is loaded, the ID is the index of the rule, the index of the terminal or the
+        // character class
+        ReferenceKind kind = REFERENCE_RULE;
+        size_t id = 0;
+        // ID of the name in the symbols of the grammar, used to describe errors
+        size_t symbol = 0;
+        FirstSet first_set = {};
     };
     
     struct ExpressionElement
@@ -57,9 +114,318 @@ namespace Xpp
         ExpressionElementType type;
         std::string value;
         std::vector<ExpressionReference> references;
+        // ID of a constant terminal in the constant table of the grammar
+        size_t constant_id = 0;
+        // Case-insensitive constants are matched against their lower case value
+        int case_insensitive = CASE_INSENSITIVE_CLEAR;
+        std::string folded_value = "";
+        // The EdgeFlags of the edge before the element
+        int edge = EDGE_NONE;
     };
 
 
+    /**
+     * @brief Reader of the Rule Expression Language that can run at compile time, malformed expressions throw
+     * std::runtime_error, so in a constant expression they are compile errors
+     *
+     */
+    namespace Rel
+    {
+        struct Flags
+        {
+            int case_insensitive = CASE_INSENSITIVE_CLEAR;
+            bool boundary = false;
+            bool ignore_spaces = false;
+        };
+
+        struct Reference
+        {
+            std::string_view name;
+            Quantifier quantifier;
+        };
+
+        constexpr bool is_name_character(char ch) noexcept
+        {
+            return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9');
+        }
+
+        constexpr bool is_space(char ch) noexcept
+        {
+            return ch == ' ' || ch == '\t' || ch == '\v' || ch == '\f';
+        }
+
+        /**
+         * @brief Remove the spaces around a raw constant, a space escaped with '\\' is kept
+         *
+         * @return std::string_view
+         */
+        constexpr std::string_view trim_spaces(std::string_view raw) noexcept
+        {
+            size_t start = 0;
+            while (start < raw.length() && is_space(raw[start]))
+                start++;
+            size_t end = raw.length();
+            while (end > start && is_space(raw[end - 1]))
+            {
+                size_t backslashes = 0;
+                while (end - 1 - backslashes > start && raw[end - 2 - backslashes] == '\\')
+                    backslashes++;
+                if (backslashes % 2 == 1)
+                    break;
+                end--;
+            }
+            return raw.substr(start, end - start);
+        }
+
+        constexpr char get_next(std::string_view exp, size_t &index) noexcept
+        {
+            return index < exp.length() ? exp[index++] : '\0';
+        }
+
+        /**
+         * @brief Decode the escapes of a constant read by `read`, the output must have room for the raw constant
+         *
+         * @return size_t the length of the decoded constant
+         */
+        constexpr size_t unescape(std::string_view raw, char *out) noexcept
+        {
+            size_t length = 0;
+            for (size_t i = 0; i < raw.length(); i++)
+            {
+                char ch = raw[i];
+                if (ch == '\\')
+                {
+                    // A trailing backslash is dropped
+                    if (++i == raw.length())
+                        break;
+                    switch (ch = raw[i])
+                    {
+                    case 't':
+                        ch = '\t';
+                        break;
+                    case 'n':
+                        ch = '\n';
+                        break;
+                    case 'r':
+                        ch = '\r';
+                        break;
+                    case 'v':
+                        ch = '\v';
+                        break;
+                    case '0':
+                        ch = '\0';
+                        break;
+                    }
+                }
+                out[length++] = ch;
+            }
+            return length;
+        }
+
+        constexpr Flags read_flags(std::string_view exp, size_t &index)
+        {
+            Flags flags;
+            char next = get_next(exp, index);
+            while (next != ']')
+            {
+                switch (next)
+                {
+                case '\0':
+                    throw std::runtime_error("Unexpected the end of the expression, ']' was expected");
+                case 'i':
+                    if (flags.case_insensitive == CASE_INSENSITIVE_STRICT)
+                        throw std::runtime_error("Cannot set 'i' flag after 'I' was already set");
+                    if (flags.case_insensitive == CASE_INSENSITIVE_SOFT)
+                        throw std::runtime_error("'i' flag is already set");
+                    flags.case_insensitive = CASE_INSENSITIVE_SOFT;
+                    break;
+                case 'I':
+                    if (flags.case_insensitive == CASE_INSENSITIVE_SOFT)
+                        throw std::runtime_error("Cannot set 'I' flag after 'i' was already set");
+                    if (flags.case_insensitive == CASE_INSENSITIVE_STRICT)
+                        throw std::runtime_error("'I' flag is already set");
+                    flags.case_insensitive = CASE_INSENSITIVE_STRICT;
+                    break;
+                case 'b':
+                    if (flags.boundary)
+                        throw std::runtime_error("'b' flag is already set");
+                    flags.boundary = true;
+                    break;
+                case 's':
+                    if (flags.ignore_spaces)
+                        throw std::runtime_error("'s' flag is already set");
+                    flags.ignore_spaces = true;
+                    break;
+                case '<':
+                    throw std::runtime_error("Unrecognized '<' token. Did you forget ']'?");
+                default:
+                    throw std::runtime_error("Unrecognized '" + std::string(1, next) + "' flag");
+                }
+                next = get_next(exp, index);
+            }
+            return flags;
+        }
+
+        // Reads the value of a {} quantifier, the index is after '{'
+        constexpr Quantifier read_range(std::string_view exp, size_t &index)
+        {
+            size_t values[2] = {0, 0};
+            bool empty[2] = {true, true};
+            size_t current_value = 0;
+            char ch = get_next(exp, index);
+            while (ch != '}')
+            {
+                if (ch == '\0')
+                    throw std::runtime_error("Unexpected the end of the expression. Did you forget '>'?");
+                if (ch == ':')
+                {
+                    if (current_value != 0)
+                        throw std::runtime_error("Unexpected ':' token");
+                    current_value = 1;
+                    ch = get_next(exp, index);
+                    continue;
+                }
+                if (ch < '0' || ch > '9')
+                    throw std::runtime_error("Unexpected token '" + std::string(1, ch) + "' in {} quantifier");
+                if (values[current_value] > (SIZE_MAX - 9) / 10)
+                    throw std::runtime_error("The value of the {} quantifier is too large");
+                values[current_value] = values[current_value] * 10 + (ch - '0');
+                empty[current_value] = false;
+                ch = get_next(exp, index);
+            }
+
+            if (current_value == 1)
+            {
+                if (empty[0])
+                    throw std::runtime_error("Expected value before ':' in '{:" + std::to_string(values[1]) + "}'");
+                if (empty[1])
+                    throw std::runtime_error("Expected value after ':' in '{" + std::to_string(values[0]) + ":}'");
+                if (values[0] > values[1])
+                    throw std::runtime_error("The minimum of the range quantifier is greater than the maximum");
+                return Quantifier{EXACT_RANGE, values[0], values[1]};
+            }
+            if (empty[0])
+                throw std::runtime_error("Expected a value after '{'");
+            return Quantifier{EXACT_VALUE, values[0], 0};
+        }
+
+        // Reads a reference or an alternative, the index is after '<'
+        template <typename Handler>
+        constexpr void read_reference(std::string_view exp, size_t &index, Handler &handler)
+        {
+            std::vector<Reference> references;
+            size_t name_start = index;
+            Quantifier quantifier{NONE, 0, 0};
+            char next = get_next(exp, index);
+            while (true)
+            {
+                if (next == '\0')
+                    throw std::runtime_error("Unexpected the end of the expression. Did you forget '>'?");
+
+                if (next == '|' || next == '>' || next == '?' || next == '*' || next == '+' || next == '{')
+                {
+                    std::string_view name = exp.substr(name_start, index - 1 - name_start);
+                    if (name.empty())
+                        throw std::runtime_error(references.empty() ? "Expected the name of a reference after '<'" : "Unexpected the end of the reference after '|'");
+                    if (next == '{')
+                    {
+                        quantifier = read_range(exp, index);
+                        next = get_next(exp, index);
+                    }
+                    else if (next != '|' && next != '>')
+                    {
+                        quantifier = Quantifier{next == '?' ? ZERO_OR_ONE : next == '*' ? ZERO_OR_MORE
+                                                                                        : ONE_OR_MORE,
+                                                0, 0};
+                        next = get_next(exp, index);
+                        if (next == '|' || !references.empty())
+                            throw std::runtime_error("Cannot use ?, *, + and range quantifier with an alternative references");
+                        if (next != '>')
+                            throw std::runtime_error("Unexpected '" + std::string(1, next) + "' token, '>' was expected");
+                    }
+                    references.push_back(Reference{name, quantifier});
+                    if (quantifier.type == EXACT_RANGE && (next == '|' || references.size() > 1))
+                        throw std::runtime_error("Cannot use range quantifier with alternative references");
+                    if (next == '>')
+                        break;
+                    if (next != '|')
+                        throw std::runtime_error(next == '\0' ? "Unexpected the end of the expression. Did you forget '>'?" : "Unexpected '" + std::string(1, next) + "' token, '>' was expected");
+                    name_start = index;
+                    quantifier = Quantifier{NONE, 0, 0};
+                    next = get_next(exp, index);
+                    continue;
+                }
+
+                if (!is_name_character(next))
+                    throw std::runtime_error("Unexpected '" + std::string(1, next) + "' token");
+                next = get_next(exp, index);
+            }
+            handler.reference(references.data(), references.size(), references.size() > 1);
+        }
+
+        // Reads a constant up to the next reference, the escapes are checked but not decoded. With the 's' flag
+        // the spaces around the constant are ignored and a constant made only of spaces is dropped
+        template <typename Handler>
+        constexpr void read_constant(std::string_view exp, size_t &index, Handler &handler, bool ignore_spaces)
+        {
+            size_t start = index;
+            bool escape = false;
+            while (index < exp.length())
+            {
+                char ch = exp[index];
+                if (escape)
+                {
+                    if (ch == 'b')
+                        throw std::runtime_error("Cannot match \\b character");
+                    escape = false;
+                }
+                else if (ch == '\\')
+                    escape = true;
+                else if (ch == '<')
+                    break;
+                else if (ch == '>')
+                    throw std::runtime_error("Unexpected '>' token");
+                index++;
+            }
+            std::string_view raw = exp.substr(start, index - start);
+            if (ignore_spaces)
+                raw = trim_spaces(raw);
+            if (!raw.empty())
+                handler.constant(raw);
+        }
+
+        /**
+         * @brief Read a rule expression, the handler gets the flags with `flags(const Flags &)`, then every
+         * constant with `constant(std::string_view)` and every reference or alternative with
+         * `reference(const Reference *, size_t, bool)`
+         *
+         */
+        template <typename Handler>
+        constexpr void read(std::string_view exp, Handler &handler)
+        {
+            size_t index = 0;
+            Flags flags;
+            if (exp.starts_with('['))
+            {
+                index++;
+                flags = read_flags(exp, index);
+            }
+            handler.flags(flags);
+            while (index < exp.length())
+            {
+                if (exp[index] == '[')
+                    throw std::runtime_error("Unexpected '[' token. Did you mean '\\['?");
+                if (exp[index] == '<')
+                {
+                    index++;
+                    read_reference(exp, index, handler);
+                }
+                else
+                    read_constant(exp, index, handler, flags.ignore_spaces);
+            }
+        }
+    };
+
     class RuleExpression
     {
     private:
@@ -69,12 +435,9 @@ namespace Xpp
         bool ignore_spaces = false;
         size_t index = 0;
         std::string rule_name;
-
-        void parse_flags(std::string);
-        void parse_expression(std::string);
-        void parse_constant_term(std::string);
-        void parse_reference(std::string);
-        Quantifier parse_quantifier(std::string, bool, char);
+        FirstSet first_set;
+        // The EdgeFlags of the edge after the last element
+        int end_edge = EDGE_NONE;
 
     public:
         RuleExpression() = default;
@@ -87,11 +450,35 @@ namespace Xpp
         bool is_soft_case_insensitive_set() noexcept;
 
         std::vector<ExpressionElement> &get_elements() noexcept;
+        const std::vector<ExpressionElement> &get_elements() const noexcept;
         ExpressionElement &operator[](size_t index) noexcept;
 
         std::vector<ExpressionElement>::iterator begin();
         std::vector<ExpressionElement>::iterator end();
 
+        std::vector<ExpressionElement>::const_iterator begin() const;
+        std::vector<ExpressionElement>::const_iterator end() const;
+
         size_t get_last_index() noexcept;
+
+        FirstSet &get_first_set() noexcept;
+        const FirstSet &get_first_set() const noexcept;
+
+        inline int get_end_edge() const noexcept
+        {
+            return end_edge;
+        }
+
+        /**
+         * @brief Write the elements, the flags and the FIRST set to a binary image of the grammar
+         *
+         */
+        void save(ImageWriter &) const;
+
+        /**
+         * @brief Read the expression from a binary image of the grammar
+         *
+         */
+        void load(ImageReader &);
     };
 };
\ No newline at end of file
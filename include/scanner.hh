@@ -0,0 +1,131 @@
+/**
+ * @file scanner.hh
+ * @author Simone Ancona
+ * @brief Vectorized scanners for the character classes of the predefined terminals
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace Xpp
+{
+    enum CharacterClass
+    {
+        CLASS_ALNUM,
+        CLASS_DIGIT,
+        CLASS_ALPHA,
+        CLASS_SPACE,
+        CLASS_HEX_DIGIT,
+        CLASS_OCT_DIGIT,
+        CLASS_ANY,
+        CLASS_IDENTIFIER,
+    };
+
+    enum ScannerLevel
+    {
+        SCANNER_SCALAR,
+        SCANNER_SSE2,
+        SCANNER_AVX2,
+    };
+
+    namespace Scanner
+    {
+        /**
+         * @brief Check if a character belongs to a class with a single table lookup
+         *
+         * @return true
+         * @return false
+         */
+        bool is_in_class(CharacterClass, char) noexcept;
+
+        /**
+         * @brief Get the length of the run of characters of a class at the beginning of the buffer, using the best
+         * implementation supported by the CPU
+         *
+         * @return size_t
+         */
+        size_t scan(CharacterClass, const char *, size_t) noexcept;
+
+        /**
+         * @brief Get the length of the run of characters of a class using a specific implementation, the level must
+         * be supported by the CPU
+         *
+         * @return size_t
+         */
+        size_t scan(CharacterClass, const char *, size_t, ScannerLevel) noexcept;
+
+        /**
+         * @brief Get the best implementation supported by the CPU, chosen once at startup
+         *
+         * @return ScannerLevel
+         */
+        ScannerLevel get_level() noexcept;
+
+        /**
+         * @brief Check if an implementation is supported by the CPU
+         *
+         * @return true
+         * @return false
+         */
+        bool is_supported(ScannerLevel) noexcept;
+
+        /**
+         * @brief Get the class of an implicit terminal name, if it is a character class
+         *
+         * @return true if the name is a character class
+         */
+        bool get_class(const std::string &, CharacterClass &) noexcept;
+
+        /**
+         * @brief Length of the match of `\r?\n`, 0 if there is no match
+         *
+         * @return size_t
+         */
+        size_t scan_new_line(const char *, size_t) noexcept;
+
+        /**
+         * @brief Length of the match of the predefined `integer` terminal, 0 if there is no match
+         *
+         * @return size_t
+         */
+        size_t scan_integer(const char *, size_t) noexcept;
+
+        /**
+         * @brief Length of the match of the predefined `identifier` terminal, 0 if there is no match
+         *
+         * @return size_t
+         */
+        size_t scan_identifier(const char *, size_t) noexcept;
+
+        /**
+         * @brief Length of the match of the predefined `real` terminal, 0 if there is no match
+         *
+         * @return size_t
+         */
+        size_t scan_real(const char *, size_t) noexcept;
+
+        /**
+         * @brief Compare a buffer with a lower case string ignoring the case of ASCII letters, both must have the
+         * given length. In strict mode the letters of the buffer must be all lower case or all upper case
+         *
+         * @return true
+         * @return false
+         */
+        bool equals_folded(const char *, const char *, size_t, bool) noexcept;
+
+        /**
+         * @brief Convert the ASCII letters of a string to lower case
+         *
+         * @return std::string
+         */
+        std::string fold(std::string_view);
+    };
+};
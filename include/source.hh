@@ -0,0 +1,82 @@
+/**
+ * @file source.hh
+ * @author Simone Ancona
+ * @brief Input buffers shared by the tokens and the AST
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <stdexcept>
+
+namespace Xpp
+{
+    /**
+     * @brief An immutable input buffer, either an owned string or a read-only memory mapping of a file
+     *
+     * Sources are shared through std::shared_ptr: every AST node that refers to the input keeps its source alive.
+     */
+    class Source
+    {
+    private:
+        std::string content;
+        const char *data = nullptr;
+        size_t length = 0;
+        void *mapping = nullptr;
+        size_t mapping_length = 0;
+
+        Source() = default;
+
+    public:
+        Source(const Source &) = delete;
+        Source &operator=(const Source &) = delete;
+
+        /**
+         * @brief Destroy the Source object, unmapping the file if it was mapped
+         *
+         */
+        ~Source();
+
+        /**
+         * @brief Create a source that owns a copy of the string
+         *
+         * @return std::shared_ptr<const Source>
+         */
+        static std::shared_ptr<const Source> from_string(std::string);
+
+        /**
+         * @brief Map a file in memory as read-only, on systems without mmap the file is read into memory
+         *
+         * @return std::shared_ptr<const Source>
+         */
+        static std::shared_ptr<const Source> map_file(const std::string &);
+
+        /**
+         * @brief Get the content of the source
+         *
+         * @return std::string_view
+         */
+        inline std::string_view get_view() const noexcept
+        {
+            return std::string_view(data, length);
+        }
+
+        /**
+         * @brief Check if the content is a memory mapping of a file
+         *
+         * @return true
+         * @return false
+         */
+        inline bool is_mapped() const noexcept
+        {
+            return mapping != nullptr;
+        }
+    };
+};
@@ -0,0 +1,397 @@
+/**
+ * @file static_grammar.hh
+ * @author Simone Ancona
+ * @brief Grammars written in C++ and checked at compile time
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "generated.hh"
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <utility>
+
+namespace Xpp
+{
+    /**
+     * @brief String literal that can be a template argument
+     *
+     */
+    template <size_t N>
+    struct FixedString
+    {
+        char value[N] = {};
+
+        constexpr FixedString(const char (&string)[N])
+        {
+            std::copy_n(string, N, value);
+        }
+
+        constexpr std::string_view view() const noexcept
+        {
+            return {value, N - 1};
+        }
+    };
+
+    struct StaticElement
+    {
+        ExpressionElementType type;
+        // The offset of a constant in the constants of the expression, or the first reference of a reference or
+        // an alternative
+        size_t first;
+        // The length of a constant or the number of references
+        size_t count;
+    };
+
+    /**
+     * @brief Rule expression read at compile time, a malformed expression is a compile error
+     *
+     */
+    template <FixedString Expression>
+    class StaticRuleExpression
+    {
+    private:
+        struct Sizes
+        {
+            size_t elements = 0;
+            size_t references = 0;
+            size_t characters = 0;
+
+            constexpr void flags(const Rel::Flags &) {}
+
+            constexpr void constant(std::string_view raw)
+            {
+                elements++;
+                characters += raw.length() + 1;
+            }
+
+            constexpr void reference(const Rel::Reference *, size_t count, bool)
+            {
+                elements++;
+                references += count;
+            }
+        };
+
+        static constexpr Sizes measure()
+        {
+            Sizes sizes;
+            Rel::read(Expression.view(), sizes);
+            return sizes;
+        }
+
+        static constexpr Sizes sizes = measure();
+
+        // The constants are separated by a null character
+        struct Tables
+        {
+            Rel::Flags expression_flags;
+            std::array<StaticElement, sizes.elements> elements{};
+            std::array<Rel::Reference, sizes.references> references{};
+            std::array<char, sizes.characters> constants{};
+            std::array<char, sizes.characters> folded{};
+            size_t element_count = 0;
+            size_t reference_count = 0;
+            size_t character_count = 0;
+
+            constexpr void flags(const Rel::Flags &value)
+            {
+                expression_flags = value;
+            }
+
+            constexpr void constant(std::string_view raw)
+            {
+                size_t length = Rel::unescape(raw, constants.data() + character_count);
+                for (size_t i = 0; i < length; i++)
+                {
+                    char ch = constants[character_count + i];
+                    folded[character_count + i] = ch >= 'A' && ch <= 'Z' ? ch | 0x20 : ch;
+                }
+                elements[element_count++] = StaticElement{CONSTANT_TERMINAL, character_count, length};
+                character_count += length + 1;
+            }
+
+            constexpr void reference(const Rel::Reference *values, size_t count, bool alternative)
+            {
+                elements[element_count++] = StaticElement{alternative ? ALTERNATIVE : RULE_REFERENCE, reference_count, count};
+                for (size_t i = 0; i < count; i++)
+                    references[reference_count++] = values[i];
+            }
+        };
+
+        static constexpr Tables build()
+        {
+            Tables tables;
+            Rel::read(Expression.view(), tables);
+            return tables;
+        }
+
+    public:
+        static constexpr Tables tables = build();
+    };
+
+    /**
+     * @brief Rule of a compile-time grammar, with its name and its expressions
+     *
+     */
+    template <FixedString Name, FixedString... Expressions>
+    struct StaticRule
+    {
+        static constexpr std::string_view name = Name.view();
+        using expressions = std::tuple<StaticRuleExpression<Expressions>...>;
+    };
+
+    /**
+     * @brief Parser of a grammar written in C++, the first rule is the root
+     *
+     * The expressions are read and the references are resolved at compile time, so there is nothing to load at
+     * startup. Every rule, expression and element is a function template specialized for it, and it uses the
+     * runtime of the parsers generated by xparse-gen: the AST is the same as the one of Parser. References can be
+     * rules, character classes, `newLine`, `eof` and the predefined terminals, terminals with a regular expression
+     * need Parser or xparse-gen. Like Parser without prediction, every expression is tried.
+     */
+    template <typename... Rules>
+    class StaticParser : public GeneratedParser
+    {
+        static_assert(sizeof...(Rules) > 0, "No rules were specified. You must specify at least one rule");
+
+    private:
+        struct Resolved
+        {
+            ReferenceKind kind;
+            size_t id;
+        };
+
+        template <size_t R>
+        using Rule = std::tuple_element_t<R, std::tuple<Rules...>>;
+
+        template <size_t R, size_t E>
+        static constexpr const auto &tables = std::tuple_element_t<E, typename Rule<R>::expressions>::tables;
+
+        static constexpr std::array<std::string_view, sizeof...(Rules)> names = {Rules::name...};
+        // In the order of the terminals of a compiled grammar without user-defined terminals
+        static constexpr std::string_view predefined[] = {"integer", "identifier", "real"};
+        static constexpr std::string_view classes[] = {"alnum", "digit", "alpha", "space", "hexDigit", "octDigit", "any"};
+
+        static inline const std::string rule_names[] = {std::string(Rules::name)...};
+
+        static constexpr Resolved resolve(std::string_view name)
+        {
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                if (names[i] == name)
+                    return {REFERENCE_RULE, i};
+            }
+            for (size_t i = 0; i < std::size(predefined); i++)
+            {
+                if (predefined[i] == name)
+                    return {REFERENCE_TERMINAL, i};
+            }
+            for (size_t i = 0; i < std::size(classes); i++)
+            {
+                if (classes[i] == name)
+                    return {REFERENCE_CLASS, i};
+            }
+            if (name == "newLine")
+                return {REFERENCE_NEW_LINE, 0};
+            if (name == "eof")
+                return {REFERENCE_EOF, 0};
+            throw std::runtime_error("Undefined reference in a compile-time grammar");
+        }
+
+        template <size_t R, size_t E, size_t F>
+        static constexpr Resolved resolved = resolve(tables<R, E>.references[F].name);
+
+        template <size_t R, size_t E, size_t F>
+        static constexpr auto symbol = []
+        {
+            std::array<char, tables<R, E>.references[F].name.length() + 1> value{};
+            std::copy_n(tables<R, E>.references[F].name.data(), value.size() - 1, value.data());
+            return value;
+        }();
+
+        // Every constant has its own array, so the compiler knows the length of what is compared
+        template <size_t R, size_t E, size_t L, bool Folded>
+        static constexpr auto text = []
+        {
+            constexpr StaticElement el = tables<R, E>.elements[L];
+            std::array<char, el.count + 1> value{};
+            std::copy_n((Folded ? tables<R, E>.folded : tables<R, E>.constants).data() + el.first, el.count, value.data());
+            return value;
+        }();
+
+        template <size_t R, size_t... E>
+        static constexpr bool rule_uses_terminals(std::index_sequence<E...>)
+        {
+            bool found = false;
+            auto expression = [&found](const auto &expression_tables)
+            {
+                for (const Rel::Reference &ref : expression_tables.references)
+                    found = found || resolve(ref.name).kind == REFERENCE_TERMINAL;
+            };
+            (expression(tables<R, E>), ...);
+            return found;
+        }
+
+        template <size_t... R>
+        static constexpr bool uses_terminals(std::index_sequence<R...>)
+        {
+            return (rule_uses_terminals<R>(std::make_index_sequence<std::tuple_size_v<typename Rule<R>::expressions>>{}) || ...);
+        }
+
+        // The input is tokenized only if a rule references a predefined terminal
+        static std::vector<TerminalRule> terminals()
+        {
+            if (!uses_terminals(std::make_index_sequence<sizeof...(Rules)>{}))
+                return {};
+            return {{"integer", "[-+]?\\d+"}, {"identifier", "[_a-zA-Z][_a-zA-Z0-9]*"}, {"real", "[-+]?\\d+(\\.\\d+)?"}};
+        }
+
+        template <size_t R, size_t E, size_t F>
+        inline bool single(AST &ast)
+        {
+            constexpr Resolved target = resolved<R, E, F>;
+            if constexpr (target.kind == REFERENCE_TERMINAL)
+                return token(ast, rule_names[R], target.id, symbol<R, E, F>.data());
+            else
+            {
+                Index start = index;
+                AST child(rule_names[target.id], std::vector<AST>{});
+                child.set_span(start.char_index, 0, 0);
+                if (!rule<target.id>(child))
+                {
+                    rule_failed(rule_names[target.id], start);
+                    return false;
+                }
+                rule_matched(ast, std::move(child), start);
+                return true;
+            }
+        }
+
+        template <size_t R, size_t E, size_t F>
+        inline bool reference(AST &ast)
+        {
+            constexpr Resolved target = resolved<R, E, F>;
+            constexpr Quantifier quantifier = tables<R, E>.references[F].quantifier;
+            const char *name = symbol<R, E, F>.data();
+            if constexpr (target.kind != REFERENCE_RULE && target.kind != REFERENCE_TERMINAL)
+            {
+                constexpr size_t min = quantifier.type == ZERO_OR_ONE || quantifier.type == ZERO_OR_MORE ? 0 : quantifier.type == EXACT_VALUE || quantifier.type == EXACT_RANGE ? quantifier.x_value
+                                                                                                                                                                              : 1;
+                constexpr size_t max = quantifier.type == ZERO_OR_MORE || quantifier.type == ONE_OR_MORE ? SIZE_MAX : quantifier.type == EXACT_VALUE ? quantifier.x_value
+                                                                                                                  : quantifier.type == EXACT_RANGE   ? quantifier.y_value
+                                                                                                                                                     : 1;
+                return implicit_terminal(ast, rule_names[R], target.kind, target.id, min, max, name);
+            }
+            else
+            {
+                auto once = [this, &ast]
+                { return single<R, E, F>(ast); };
+                if constexpr (quantifier.type == NONE)
+                    return once();
+                else if constexpr (quantifier.type == ZERO_OR_ONE)
+                    return zero_or_one(once);
+                else if constexpr (quantifier.type == ZERO_OR_MORE)
+                    return zero_or_more(once);
+                else if constexpr (quantifier.type == ONE_OR_MORE)
+                    return one_or_more(once, rule_names[R], name);
+                else if constexpr (quantifier.type == EXACT_VALUE)
+                    return exact_value(ast, once, quantifier.x_value, rule_names[R], name);
+                else
+                    return exact_range(ast, once, quantifier.x_value, quantifier.y_value, rule_names[R], name);
+            }
+        }
+
+        template <size_t R, size_t E, size_t F, size_t... A>
+        inline bool alternative(AST &ast, std::index_sequence<A...>)
+        {
+            Index alternative_start = index;
+            bool matched = ((index = alternative_start, reference<R, E, F + A>(ast)) || ...);
+            if (!matched)
+            {
+                index = alternative_start;
+                fail(FAILURE_ALTERNATIVE, rule_names[R], nullptr);
+            }
+            return matched;
+        }
+
+        template <size_t R, size_t E, size_t L>
+        inline bool element(AST &ast)
+        {
+            constexpr StaticElement el = tables<R, E>.elements[L];
+            constexpr int case_insensitive = tables<R, E>.expression_flags.case_insensitive;
+            if constexpr (el.type == CONSTANT_TERMINAL && case_insensitive != CASE_INSENSITIVE_CLEAR)
+                return folded_constant(ast, rule_names[R], text<R, E, L, true>.data(), text<R, E, L, false>.data(), el.count, case_insensitive == CASE_INSENSITIVE_STRICT);
+            else if constexpr (el.type == CONSTANT_TERMINAL)
+                return constant(ast, rule_names[R], text<R, E, L, false>.data(), el.count);
+            else if constexpr (el.type == RULE_REFERENCE)
+                return reference<R, E, el.first>(ast);
+            else
+                return alternative<R, E, el.first>(ast, std::make_index_sequence<el.count>{});
+        }
+
+        // The edge before element L, or after the last element if L is the number of elements
+        template <size_t R, size_t E, size_t L>
+        inline bool edge(size_t start)
+        {
+            constexpr Rel::Flags flags = tables<R, E>.expression_flags;
+            if constexpr (L == 0)
+                return true;
+            else
+            {
+                if constexpr (flags.ignore_spaces && L < tables<R, E>.elements.size())
+                    skip_spaces();
+                if constexpr (flags.boundary)
+                    return boundary(rule_names[R], start);
+                else
+                    return true;
+            }
+        }
+
+        template <size_t R, size_t E, size_t... L>
+        inline bool expression(AST &ast, std::index_sequence<L...>)
+        {
+            size_t start = index.char_index;
+            return ((edge<R, E, L>(start) && element<R, E, L>(ast)) && ...) && edge<R, E, sizeof...(L)>(start);
+        }
+
+        template <size_t R, size_t... E>
+        inline bool expressions(AST &ast, std::index_sequence<E...>)
+        {
+            Index start = index;
+            size_t children = ast.get_children().size();
+            auto attempt = [&](auto matched)
+            {
+                if (matched)
+                    return true;
+                backtrack(ast, start, children);
+                return false;
+            };
+            return (attempt(expression<R, E>(ast, std::make_index_sequence<tables<R, E>.elements.size()>{})) || ...);
+        }
+
+        template <size_t R>
+        bool rule(AST &ast)
+        {
+            constexpr size_t count = std::tuple_size_v<typename Rule<R>::expressions>;
+            if (expressions<R>(ast, std::make_index_sequence<count>{}))
+                return true;
+            if (!has_failed() || count == 0)
+                fail(FAILURE_NO_EXPRESSION, rule_names[R], nullptr);
+            return false;
+        }
+
+        bool parse_root(AST &ast) override
+        {
+            return rule<0>(ast);
+        }
+
+    public:
+        StaticParser() : GeneratedParser(terminals(), std::string(names[0])) {}
+    };
+};
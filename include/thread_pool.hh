@@ -0,0 +1,76 @@
+/**
+ * @file thread_pool.hh
+ * @author Simone Ancona
+ * @brief A fixed-size pool of worker threads
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+namespace Xpp
+{
+    class ThreadPool
+    {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable available;
+        bool stopping = false;
+
+        void work();
+
+    public:
+        /**
+         * @brief Construct a new ThreadPool object, 0 threads means one per hardware thread
+         *
+         */
+        ThreadPool(size_t);
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief Destroy the ThreadPool object, waiting for the running tasks
+         *
+         */
+        ~ThreadPool();
+
+        /**
+         * @brief Get the number of threads that run tasks, including the calling thread
+         *
+         * @return size_t
+         */
+        size_t get_thread_count() const noexcept;
+
+        /**
+         * @brief Call the function for every index in [0, count) on the pool and on the calling thread, and wait
+         * for all of them. The first exception thrown by the function is rethrown
+         *
+         */
+        void parallel_for(size_t, const std::function<void(size_t)> &);
+
+        /**
+         * @brief Call the function with the number of the thread and the index for every index in [0, count), the
+         * calling thread is number 0. The indices are split in one contiguous range per thread, a thread takes the
+         * indices of its own range in order and when it runs out it steals the upper half of the range of another
+         * thread. The first exception thrown by the function is rethrown
+         *
+         */
+        void parallel_for_stealing(size_t, const std::function<void(size_t, size_t)> &);
+    };
+};
@@ -13,7 +13,14 @@
 
 #include "jpp.hh"
 #include "ast.hh"
+#include "grammar.hh"
 #include "rel.hh"
+#include "lexer.hh"
+#include "scanner.hh"
+#include "source.hh"
+#include "packrat.hh"
+#include "events.hh"
+#include "budget.hh"
 #include <regex>
 #include <string>
 #include <vector>
@@ -23,36 +30,23 @@
 #include <stdexcept>
 #include <regex>
 #include <stack>
-#include <set>
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <memory>
 
 namespace Xpp
 {
-    struct Rule
-    {
-        std::string name;
-        std::vector<RuleExpression> expressions;
-    };
-
-    struct TerminalRule
-    {
-        std::string name;
-        std::string regex;
-    };
-
-    struct Token
-    {
-        TerminalRule from;
-        size_t index;
-        size_t column;
-        size_t line;
-        std::string value;
-    };
-
     enum SyntaxErrorType
     {
         EXPECTED_TOKEN,
         UNEXPECTED_TOKEN,
         UNMATCHED_RULE,
+        // The parse was stopped by its budget or cancelled, the input may be valid
+        STEP_LIMIT_EXCEEDED,
+        TIME_LIMIT_EXCEEDED,
+        NODE_LIMIT_EXCEEDED,
+        PARSE_CANCELLED,
     };
 
     struct SyntaxError
@@ -64,21 +58,143 @@ namespace Xpp
         size_t line;
     };
 
+    // char_index is the offset in the input, token_index is the first token that does not start before it
     struct Index
     {
         size_t token_index;
         size_t char_index;
     };
 
+    enum FailureKind : uint8_t
+    {
+        FAILURE_CONSTANT,
+        FAILURE_FOLDED_CONSTANT,
+        FAILURE_REFERENCE,
+        FAILURE_ONE_OR_MORE,
+        FAILURE_EXACT_VALUE,
+        FAILURE_EXACT_RANGE,
+        FAILURE_ALTERNATIVE,
+        FAILURE_RULE,
+        FAILURE_NO_EXPRESSION,
+        FAILURE_BOUNDARY
+    };
+
+    /**
+     * @brief A failed attempt to match part of a rule, the message is only built when the error is requested
+     *
+     */
+    struct Failure
+    {
+        FailureKind kind;
+        uint32_t rule;
+        // The constant ID of a constant or the symbol ID of a reference
+        uint32_t symbol;
+        // The index of the first wrong character of a constant or the expected number of repetitions
+        uint32_t count;
+        size_t offset;
+
+        bool operator==(const Failure &) const = default;
+    };
+
+    /**
+     * @brief Build the syntax error of a failure in a rule, the text is the constant or the name of the expected
+     * reference and the count is the index of the wrong character or the expected number of repetitions
+     *
+     * @return SyntaxError
+     */
+    SyntaxError format_failure(FailureKind, const std::string &, std::string_view, size_t, size_t, const ParserTools::LineIndex &);
+
+    // The repetitions of an implicit terminal, the length of the match and the number of characters read to find it
+    struct ImplicitMatch
+    {
+        size_t count;
+        size_t length;
+        size_t read;
+    };
+
+    /**
+     * @brief Match at most max repetitions of a character class, a new line or the end of the input at the beginning
+     * of the input
+     *
+     * @return ImplicitMatch
+     */
+    ImplicitMatch scan_implicit_terminal(ReferenceKind, size_t, size_t, size_t, std::string_view) noexcept;
+
+    // Result of a rule at an offset, a failed rule keeps the failure that made it fail
+    struct PackratResult
+    {
+        bool matched;
+        Index end;
+        AST node;
+        Failure failure;
+        // The end of the input read to match the rule
+        size_t read_end;
+    };
+
+    enum ParserEngine
+    {
+        // Every rule reference is a call of the parser, the depth of the input is limited by the size of the stack
+        ENGINE_RECURSIVE,
+        // Rule references are frames of a stack allocated on the heap, the depth is only limited by the memory
+        ENGINE_ITERATIVE,
+        // The rules compiled to bytecode run in a single dispatch loop, the depth is only limited by the memory
+        ENGINE_BYTECODE
+    };
+
+    struct PredictionStatistics
+    {
+        // Expressions of rules that were tried and that were skipped because of their FIRST set
+        size_t expressions_tried = 0;
+        size_t expressions_pruned = 0;
+        // References of alternatives that were tried and that were skipped because of their FIRST set
+        size_t alternatives_tried = 0;
+        size_t alternatives_pruned = 0;
+    };
+
+    /**
+     * @brief Result of a parse that does not throw on syntax errors
+     *
+     */
+    struct ParseResult
+    {
+        bool success;
+        AST ast;
+        // The last error if the parse failed
+        SyntaxError error;
+
+        explicit inline operator bool() const noexcept
+        {
+            return success;
+        }
+    };
+
+    /**
+     * @brief Replace `removed` bytes at an offset with the inserted string, the offset is in the input after the
+     * previous edits of the same list
+     *
+     */
+    struct TextEdit
+    {
+        size_t offset;
+        size_t removed;
+        std::string inserted;
+    };
+
+    struct BatchOptions
+    {
+        // Number of threads used by parse_batch, 0 uses every hardware thread
+        size_t threads = 0;
+    };
+
     class SyntaxErrorException : public std::exception
     {
     private:
-        const char *message;
+        std::string message;
     public:
 
         SyntaxErrorException(const std::string message) noexcept
         {
-            this->message = message.c_str();
+            this->message = message;
         }
 
         SyntaxErrorException(const char *message) noexcept
@@ -86,49 +202,118 @@ namespace Xpp
             this->message = message;
         }
 
-        inline const char *what() noexcept
+        inline const char *what() const noexcept override
         {
-            return message;
+            return message.c_str();
         }
     };
 
-    bool token_compare(Token, Token);
-
     class Parser
     {
     private:
-        Jpp::Json grammar;
-        std::vector<Rule> rules;
-        std::vector<TerminalRule> terminals = {{"integer", "[-|+]?\\d+"}, {"identifier", "[_a-zA-Z][_a-zA-Z0-9]*"}, {"real", "[+|-]?\\d+(\\.\\d+)?"}};
-        const std::vector<std::string> implicit_terminals = {"alnum", "digit", "alpha", "space", "hexDigit", "octDigit", "eof", "newLine", "any"};
+        std::shared_ptr<const CompiledGrammar> grammar;
+        size_t probe_index;
+        std::vector<uint32_t> probe_path;
+        TokenizerOptions tokenizer_options;
+        std::shared_ptr<ThreadPool> pool;
+        BatchOptions batch_options;
+        std::shared_ptr<ThreadPool> batch_pool;
+        // One parser per thread of the batch pool, kept between batches so their buffers are reused
+        std::vector<Parser> batch_parsers;
+        PackratOptions packrat_options;
+        PackratCache<PackratResult> packrat_cache;
+        bool incremental = false;
+        // The reads of the tokenizer for every token of the last input, only kept if incremental parsing is enabled
+        std::vector<size_t> token_reads;
+        // The end of the input read by the rule being matched
+        size_t read_end = 0;
+        // The AST of the previous input while the edited one is parsed, and the range that changed in both inputs
+        AST previous_tree;
+        bool reusing = false;
+        size_t damage_begin = 0;
+        size_t damage_end = 0;
+        size_t damage_new_end = 0;
+        // The source and the root span of the AST of the last successful parse, the only AST reparse can reuse
+        std::shared_ptr<const Source> parsed_source;
+        size_t parsed_length = 0;
+        size_t parsed_lookahead = 0;
+        // The handler of the events while parse_events runs, the AST is not built when it is set
+        EventHandler *events = nullptr;
+        ParseBudget budget;
+        // Steps and nodes of the current parse, the time and the cancellation are checked again at next_check
+        size_t steps = 0;
+        size_t nodes = 0;
+        size_t next_check = SIZE_MAX;
+        std::chrono::steady_clock::time_point deadline;
+        bool budget_exceeded = false;
+        SyntaxErrorType budget_error;
+        size_t budget_offset = 0;
+        bool prediction = true;
+        ParserEngine engine = ENGINE_RECURSIVE;
+        PredictionStatistics prediction_statistics;
+        // Only the failures at the farthest offset are kept, the error stack is built from them when requested
+        std::vector<Failure> failures;
+        Failure last_failure;
         std::stack<SyntaxError> error_stack;
+        bool error_stack_built = true;
 
         Index parse_index;
-        std::string input;
-
-        void generate_from_json();
-        void generate_terminal_rules(const std::map<std::string, Jpp::Json> &);
-        void generate_rules(const std::map<std::string, Jpp::Json> &);
-        std::vector<RuleExpression> parse_expressions(const std::map<std::string, Jpp::Json> &, std::set<std::pair<std::string, std::string>> &, const std::string &);
-        void get_reference_names(RuleExpression &, std::set<std::pair<std::string, std::string>> &, const std::string &);
-        Rule *find_rule(const std::string &);
-        TerminalRule *find_terminal_rule(const std::string &);
-        std::string get_string_from_file(const std::ifstream &);
-        std::vector<Token> tokenize(const std::string &);
-        Xpp::AST parse(const std::vector<Token> &);
-        std::vector<Token> get_tokens(const std::string &, TerminalRule);
-        std::pair<size_t, size_t> get_column_line(std::string_view, long long);
-        void analyze_rule(Xpp::AST &, const std::vector<Token> &, const Rule &);
-        bool analyze_expression(Xpp::AST &, const std::vector<Token> &, RuleExpression &, const std::string &);
-        bool analyze_alternative(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_reference(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_single_reference(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_zero_or_one(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_zero_or_more(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_one_or_more(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_exact_quantity(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_exact_range(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
-        bool analyze_constant(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const std::string &);
+        std::shared_ptr<const Source> source;
+        std::string_view input;
+        std::vector<Token> token_buffer;
+        ParserTools::LineIndex lines;
+
+        bool is_viable(const FirstSet &, const std::vector<Token> &) noexcept;
+        const std::vector<Token> &tokenize_input();
+        ParseResult parse(const std::vector<Token> &);
+        Xpp::AST generate_ast(std::shared_ptr<const Source>, std::string_view);
+        ParseResult try_generate_ast(std::shared_ptr<const Source>, std::string_view);
+        Xpp::AST make_terminal(const std::string &, size_t, size_t);
+        void emit_terminal(Xpp::AST &, const Rule &, size_t, size_t);
+        void begin_expression(const Rule &);
+        void end_expression(const Rule &, size_t, bool);
+        void attach(Xpp::AST &, Xpp::AST);
+        void mark_read(size_t) noexcept;
+        bool is_last_tree(Xpp::AST &);
+        Xpp::AST *find_previous(size_t, size_t);
+        bool reuse_rule(Xpp::AST &, const std::vector<Token> &, size_t);
+        void start_budget();
+        bool check_budget() noexcept;
+        bool exceed_budget(SyntaxErrorType) noexcept;
+        SyntaxError describe_budget() const;
+
+        // Count a step of the engine, false once the parse exceeded its budget
+        inline bool spend_step() noexcept
+        {
+            return ++steps < next_check || check_budget();
+        }
+
+        void record_failure(const Failure &);
+        void push_failure(FailureKind, const Rule &, size_t = 0, size_t = 0);
+        SyntaxError describe_failure(const Failure &) const;
+        void advance_to(const std::vector<Token> &, size_t);
+        void backtrack(Xpp::AST &, Index, size_t);
+        bool analyze_rule(Xpp::AST &, const std::vector<Token> &, const Rule &);
+        bool analyze_expression(Xpp::AST &, const std::vector<Token> &, const RuleExpression &, const Rule &);
+        bool analyze_alternative(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const Rule &);
+        bool analyze_reference(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_single_reference(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_zero_or_one(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_zero_or_more(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_one_or_more(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_exact_quantity(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_exact_range(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_implicit_terminal(Xpp::AST &, const std::vector<Token> &, const ExpressionReference &, const Rule &);
+        bool analyze_constant(Xpp::AST &, const std::vector<Token> &, const ExpressionElement &, const Rule &);
+        bool match_constant(Xpp::AST &, const std::vector<Token> &, const Rule &, size_t, std::string_view);
+        bool match_folded_constant(Xpp::AST &, const std::vector<Token> &, const Rule &, size_t, std::string_view, bool);
+        bool match_implicit_terminal(Xpp::AST &, const std::vector<Token> &, const Rule &, ReferenceKind, size_t, size_t, size_t, size_t);
+        bool match_edge(const std::vector<Token> &, const Rule &, int, size_t);
+        bool replay_rule(Xpp::AST &, size_t, bool &);
+        void rule_matched(Xpp::AST &, size_t, Index, size_t, Xpp::AST);
+        void rule_failed(size_t, Index, size_t);
+        bool analyze_rule_iterative(Xpp::AST &, const std::vector<Token> &);
+        bool analyze_rule_bytecode(Xpp::AST &, const std::vector<Token> &);
 
     public:
         /**
@@ -155,12 +340,40 @@ namespace Xpp
          */
         Parser(const std::ifstream &);
 
+        /**
+         * @brief Construct a new Parser object that uses a compiled grammar, the grammar can be shared by parsers
+         * running on different threads
+         *
+         */
+        Parser(std::shared_ptr<const CompiledGrammar>);
+
         /**
          * @brief Destroy the Parser object
          *
          */
         ~Parser() = default;
 
+        /**
+         * @brief Get the compiled grammar used by the parser
+         *
+         * @return std::shared_ptr<const CompiledGrammar>
+         */
+        std::shared_ptr<const CompiledGrammar> get_grammar() const noexcept;
+
+        /**
+         * @brief Save the compiled grammar to a binary image that load_compiled reads back without parsing the
+         * JSON grammar or any rule expression
+         *
+         */
+        void save_compiled(const std::string &) const;
+
+        /**
+         * @brief Use the compiled grammar of a binary image saved by save_compiled, the file is mapped in memory.
+         * Images of another version or damaged ones throw std::runtime_error
+         *
+         */
+        void load_compiled(const std::string &);
+
         /**
          * @brief Get the ast object
          *
@@ -168,12 +381,179 @@ namespace Xpp
          */
         AST generate_ast(const std::string &);
 
+        /**
+         * @brief Get the ast object parsing the buffer in place, the values of the AST refer to the buffer so it
+         * must outlive the AST
+         *
+         * @return AST
+         */
+        AST generate_ast(std::string_view);
+
+        /**
+         * @brief Get the ast object
+         *
+         * @return AST
+         */
+        AST generate_ast(const char *);
+
+        /**
+         * @brief Get the ast object of a file, the file is mapped in memory and parsed in place. The mapping is
+         * released when both the AST and the parser no longer refer to it
+         *
+         * @return AST
+         */
+        AST generate_ast_from_file(const std::string &);
+
+        /**
+         * @brief Get the ast object without throwing on syntax errors
+         *
+         * @return ParseResult
+         */
+        ParseResult try_generate_ast(const std::string &);
+
+        /**
+         * @brief Get the ast object parsing the buffer in place without throwing on syntax errors, the values of
+         * the AST refer to the buffer so it must outlive the AST
+         *
+         * @return ParseResult
+         */
+        ParseResult try_generate_ast(std::string_view);
+
+        /**
+         * @brief Get the ast object without throwing on syntax errors
+         *
+         * @return ParseResult
+         */
+        ParseResult try_generate_ast(const char *);
+
+        /**
+         * @brief Apply the edits to the last input and parse it again without throwing on syntax errors, the AST
+         * should be the one of the last input
+         *
+         * If incremental parsing is enabled only the tokens that read the edited bytes are tokenized again, and
+         * every node of the previous AST that did not read them is moved into the new AST instead of being parsed
+         * again. Otherwise, or if the AST is not the one of the last successful parse, the edited input is parsed
+         * from scratch. The edited input is owned by the new AST.
+         *
+         * @return ParseResult
+         */
+        ParseResult reparse(AST, const std::vector<TextEdit> &);
+
+        /**
+         * @brief Parse the buffer in place and send the matched rules and terminals to the handler instead of
+         * building an AST, the AST of the result is empty
+         *
+         * The spans of the events are views of the buffer. The parser only keeps the rules being matched, so
+         * memory grows with the depth of the input besides the tokens. Packrat parsing is not used.
+         *
+         * @return ParseResult
+         */
+        ParseResult parse_events(std::string_view, EventHandler &);
+
+        /**
+         * @brief Parse a file mapped in memory and send the matched rules and terminals to the handler, the
+         * mapping is kept until the parser parses another input
+         *
+         * @return ParseResult
+         */
+        ParseResult parse_events_from_file(const std::string &, EventHandler &);
+
+        /**
+         * @brief Parse many inputs on a work-stealing thread pool without throwing on syntax errors, the values
+         * of the ASTs refer to the buffers so they must outlive the ASTs
+         *
+         * Every thread parses with its own parser that shares the compiled grammar, the engine, the prediction,
+         * the packrat options and the budget of this one, the parsers are kept between calls so their buffers are
+         * reused. The workers tokenize every input sequentially, since the inputs already run in parallel, and do
+         * not keep the state of incremental parsing. The results are in the order of the inputs.
+         *
+         * @return std::vector<ParseResult>
+         */
+        std::vector<ParseResult> parse_batch(std::span<const std::string_view>);
+
+        /**
+         * @brief Split the input string into tokens using the compiled terminal rules, the tokens are spans of the
+         * string so it must outlive them
+         *
+         * @return std::vector<Token>
+         */
+        std::vector<Token> tokenize(std::string_view);
+
+        /**
+         * @brief Set the number of threads and the chunk size used by the tokenizer, by default the input is
+         * tokenized on the calling thread
+         *
+         */
+        void set_tokenizer_options(const TokenizerOptions &);
+
+        /**
+         * @brief Enable or disable packrat parsing, by default every rule is matched again after backtracking
+         *
+         */
+        void set_packrat_options(const PackratOptions &);
+
+        /**
+         * @brief Set the number of threads used by parse_batch, by default every hardware thread
+         *
+         */
+        void set_batch_options(const BatchOptions &);
+
+        /**
+         * @brief Set the limits of every following parse, a parse that exceeds them fails with the error type of
+         * the limit. By default there is no limit
+         *
+         */
+        void set_budget(const ParseBudget &);
+
+        /**
+         * @brief Enable or disable predictive parsing, enabled by default. Expressions and references of
+         * alternatives are only tried if the input can start them, according to their FIRST set. The last
+         * expression of a rule is always tried, so prediction changes neither the result nor the last error
+         *
+         */
+        void set_prediction(bool) noexcept;
+
+        /**
+         * @brief Enable or disable incremental parsing, disabled by default. The parser keeps how far the input was
+         * read to find every token and node, so reparse only parses again what an edit can change. The tokenizer
+         * always runs on the calling thread when it is enabled
+         *
+         */
+        void set_incremental(bool) noexcept;
+
+        /**
+         * @brief Set the engine used to parse, by default the recursive one
+         *
+         */
+        void set_engine(ParserEngine) noexcept;
+
+        /**
+         * @brief Get how many expressions and alternatives were tried and skipped while parsing the last input
+         *
+         * @return const PredictionStatistics&
+         */
+        const PredictionStatistics &get_prediction_statistics() const noexcept;
+
+        /**
+         * @brief Get the terminal rule that matched a token
+         *
+         * @return const TerminalRule&
+         */
+        const TerminalRule &get_terminal_rule(const Token &) const;
+
+        /**
+         * @brief Get the column and the line of an offset in the last tokenized input
+         *
+         * @return std::pair<size_t, size_t>
+         */
+        std::pair<size_t, size_t> get_column_line(size_t) const noexcept;
+
         /**
          * @brief Get the error stack
          *
          * @return std::stack<SyntaxError>&
          */
-        std::stack<SyntaxError> &get_error_stack() noexcept;
+        std::stack<SyntaxError> &get_error_stack();
 
         /**
          * @brief Get the last error
@@ -19,14 +19,46 @@ Xpp::AST::AST(const std::string &rule_name, std::vector<AST> children)
 {
     this->terminal = false;
     this->rule_name = rule_name;
-    this->children = children;
+    if (!children.empty())
+        this->children = std::make_shared<std::vector<AST>>(std::move(children));
+}
+
+Xpp::AST::~AST()
+{
+    // Children shared with a copy are left to the copy
+    if (children == nullptr || children.use_count() > 1)
+        return;
+    std::vector<std::shared_ptr<std::vector<AST>>> pending;
+    pending.push_back(std::move(children));
+    while (!pending.empty())
+    {
+        std::shared_ptr<std::vector<AST>> nodes = std::move(pending.back());
+        pending.pop_back();
+        if (nodes.use_count() > 1)
+            continue;
+        for (auto &node : *nodes)
+        {
+            if (node.children != nullptr)
+                pending.push_back(std::move(node.children));
+        }
+    }
 }
 
 Xpp::AST::AST(const std::string &rule_name, const std::string &terminal_value)
+{
+    std::shared_ptr<const std::string> owned = std::make_shared<const std::string>(terminal_value);
+    this->terminal = true;
+    this->rule_name = rule_name;
+    this->value = *owned;
+    this->source = owned;
+}
+
+Xpp::AST::AST(const std::string &rule_name, std::string_view terminal_value, std::shared_ptr<const void> source)
 {
     this->terminal = true;
     this->rule_name = rule_name;
     this->value = terminal_value;
+    this->source = std::move(source);
 }
 
 bool Xpp::AST::is_terminal()
@@ -40,32 +72,61 @@ std::string Xpp::AST::get_rule_name()
 }
 
 std::string Xpp::AST::get_value()
+{
+    if (!terminal)
+        throw std::runtime_error("Cannot get the value of a non-terminal node");
+    return std::string(value);
+}
+
+std::string_view Xpp::AST::get_value_view()
 {
     if (!terminal)
         throw std::runtime_error("Cannot get the value of a non-terminal node");
     return value;
 }
 
+size_t Xpp::AST::get_start() const noexcept
+{
+    return start;
+}
+
+size_t Xpp::AST::get_length() const noexcept
+{
+    return length;
+}
+
+size_t Xpp::AST::get_lookahead() const noexcept
+{
+    return lookahead;
+}
+
+void Xpp::AST::set_span(size_t start, size_t length, size_t lookahead) noexcept
+{
+    this->start = start;
+    this->length = length;
+    this->lookahead = lookahead;
+}
+
 std::vector<Xpp::AST> &Xpp::AST::get_children()
 {
     if (terminal)
         throw std::runtime_error("Cannot get the children of an terminal node");
-    return children;
+    return own_children();
 }
 
 Xpp::AST &Xpp::AST::operator[](size_t index)
 {
-    return children[index];
+    return own_children()[index];
 }
 
 std::vector<Xpp::AST>::iterator Xpp::AST::begin()
 {
-    return children.begin();
+    return own_children().begin();
 }
 
 std::vector<Xpp::AST>::iterator Xpp::AST::end()
 {
-    return children.end();
+    return own_children().end();
 }
 
 Jpp::Json Xpp::AST::to_json()
@@ -0,0 +1,341 @@
+/**
+ * @file bytecode.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "bytecode.hh"
+#include "grammar.hh"
+#include "image.hh"
+#include <algorithm>
+
+Xpp::Bytecode::Bytecode(const Xpp::CompiledGrammar &grammar)
+{
+    for (const auto &rule : grammar.get_rules())
+    {
+        entries.push_back(static_cast<uint32_t>(code.size()));
+        for (const auto &exp : rule.expressions)
+        {
+            // The last expression is never pruned, as in the recursive engine
+            FirstSet first_set = &exp == &rule.expressions.back() ? FirstSet{.nullable = true} : exp.get_first_set();
+            uint32_t predict = emit(OP_PREDICT, add_first_set(first_set));
+            std::vector<uint32_t> failures;
+            for (const auto &el : exp.get_elements())
+            {
+                if (el.edge != EDGE_NONE)
+                    failures.push_back(emit(OP_EDGE, el.edge));
+                compile_element(el, failures);
+            }
+            if (exp.get_end_edge() != EDGE_NONE)
+                failures.push_back(emit(OP_EDGE, exp.get_end_edge()));
+            emit(OP_RETURN);
+            patch(failures, code.size());
+            emit(OP_BACKTRACK);
+            code[predict].fail = static_cast<uint32_t>(code.size());
+        }
+        emit(OP_NO_EXPRESSION);
+    }
+}
+
+size_t Xpp::Bytecode::add_first_set(const Xpp::FirstSet &set)
+{
+    // Equal sets share an entry
+    auto found = std::find(first_sets.begin(), first_sets.end(), set);
+    if (found != first_sets.end())
+        return found - first_sets.begin();
+    first_sets.push_back(set);
+    return first_sets.size() - 1;
+}
+
+size_t Xpp::Bytecode::add_text(const std::string &value)
+{
+    size_t offset = text.find(value);
+    if (offset != std::string::npos)
+        return offset;
+    text += value;
+    return text.length() - value.length();
+}
+
+size_t Xpp::Bytecode::add_repetitions(size_t min, size_t max)
+{
+    for (size_t i = 0; i < repetitions.size(); i++)
+    {
+        if (repetitions[i].min == min && repetitions[i].max == max)
+            return i;
+    }
+    repetitions.push_back({min, max});
+    return repetitions.size() - 1;
+}
+
+uint32_t Xpp::Bytecode::emit(Xpp::Opcode op, size_t a, size_t b, size_t c)
+{
+    code.push_back({op, static_cast<uint32_t>(a), static_cast<uint32_t>(b), static_cast<uint32_t>(c)});
+    return static_cast<uint32_t>(code.size() - 1);
+}
+
+void Xpp::Bytecode::patch(std::vector<uint32_t> &failures, size_t target)
+{
+    for (uint32_t instruction : failures)
+        code[instruction].fail = static_cast<uint32_t>(target);
+    failures.clear();
+}
+
+uint32_t Xpp::Bytecode::emit_single(const Xpp::ExpressionReference &ref)
+{
+    if (ref.kind == REFERENCE_TERMINAL)
+        return emit(OP_TOKEN, ref.id, 0, ref.symbol);
+    return emit(OP_CALL, ref.id);
+}
+
+void Xpp::Bytecode::compile_reference(const Xpp::ExpressionReference &ref, std::vector<uint32_t> &failures)
+{
+    const Xpp::Quantifier &quantifier = ref.quantifier;
+    if (ref.kind != REFERENCE_RULE && ref.kind != REFERENCE_TERMINAL)
+    {
+        // Implicit terminals repeat inside their instruction
+        size_t min = 1;
+        size_t max = 1;
+        switch (quantifier.type)
+        {
+        case NONE:
+            break;
+        case ZERO_OR_ONE:
+            min = 0;
+            break;
+        case ZERO_OR_MORE:
+            min = 0;
+            max = SIZE_MAX;
+            break;
+        case ONE_OR_MORE:
+            max = SIZE_MAX;
+            break;
+        case EXACT_VALUE:
+            min = max = quantifier.x_value;
+            break;
+        case EXACT_RANGE:
+            min = quantifier.x_value;
+            max = quantifier.y_value;
+            break;
+        }
+        Xpp::Opcode op = ref.kind == REFERENCE_CLASS ? OP_CLASS : ref.kind == REFERENCE_NEW_LINE ? OP_NEW_LINE : OP_EOF;
+        failures.push_back(emit(op, ref.id, add_repetitions(min, max), ref.symbol));
+        return;
+    }
+
+    uint32_t loop;
+    switch (quantifier.type)
+    {
+    case NONE:
+        failures.push_back(emit_single(ref));
+        break;
+    case ZERO_OR_ONE:
+        loop = emit_single(ref);
+        code[loop].fail = loop + 1;
+        break;
+    case ZERO_OR_MORE:
+    case ONE_OR_MORE:
+        emit(OP_MARK);
+        loop = emit_single(ref);
+        emit(quantifier.type == ZERO_OR_MORE ? OP_AGAIN : OP_AGAIN_COUNT, loop);
+        code[loop].fail = loop + 2;
+        if (quantifier.type == ZERO_OR_MORE)
+            emit(OP_RESTORE);
+        else
+            failures.push_back(emit(OP_AT_LEAST_ONE, 0, 0, ref.symbol));
+        break;
+    case EXACT_VALUE:
+        // No repetition at all never matches the reference
+        if (quantifier.x_value == 0)
+            break;
+        emit(OP_MARK_EXACT);
+        loop = emit_single(ref);
+        emit(OP_REPEAT, loop, quantifier.x_value, loop + 3);
+        code[loop].fail = loop + 2;
+        failures.push_back(emit(OP_REPEAT_FAILED, 0, quantifier.x_value, ref.symbol));
+        break;
+    case EXACT_RANGE:
+        if (quantifier.y_value == 0 && quantifier.x_value == 0)
+            break;
+        emit(OP_MARK_EXACT);
+        if (quantifier.y_value != 0)
+        {
+            loop = emit_single(ref);
+            emit(OP_RANGE, loop, quantifier.y_value);
+            code[loop].fail = loop + 2;
+        }
+        failures.push_back(emit(OP_RANGE_END, 0, quantifier.x_value, ref.symbol));
+        break;
+    }
+}
+
+void Xpp::Bytecode::compile_element(const Xpp::ExpressionElement &el, std::vector<uint32_t> &failures)
+{
+    switch (el.type)
+    {
+    case CONSTANT_TERMINAL:
+        if (el.case_insensitive == CASE_INSENSITIVE_CLEAR)
+            failures.push_back(emit(OP_STRING, add_text(el.value), el.value.length(), el.constant_id));
+        else
+            failures.push_back(emit(el.case_insensitive == CASE_INSENSITIVE_STRICT ? OP_FOLDED_STRICT : OP_FOLDED, add_text(el.folded_value), el.value.length(), el.constant_id));
+        return;
+    case RULE_REFERENCE:
+        compile_reference(el.references[0], failures);
+        return;
+    case ALTERNATIVE:
+        break;
+    }
+
+    // Every reference fails to the next one, the last one to the failure of the alternative
+    std::vector<uint32_t> next;
+    std::vector<uint32_t> ends;
+    emit(OP_CHOICE);
+    for (const auto &ref : el.references)
+    {
+        patch(next, code.size());
+        next.push_back(emit(OP_ALTERNATIVE, add_first_set(ref.first_set)));
+        compile_reference(ref, next);
+        ends.push_back(emit(OP_JUMP));
+    }
+    patch(next, code.size());
+    failures.push_back(emit(OP_NO_ALTERNATIVE));
+    for (uint32_t end : ends)
+        code[end].a = static_cast<uint32_t>(code.size());
+}
+
+std::string Xpp::Bytecode::dump(const Xpp::CompiledGrammar &grammar) const
+{
+    static const char *names[] = {"PREDICT", "RETURN", "BACKTRACK", "NO_EXPRESSION", "STRING", "FOLDED", "FOLDED_STRICT", "CLASS", "NEW_LINE", "EOF", "TOKEN", "CALL", "CHOICE",
+                                  "ALTERNATIVE", "NO_ALTERNATIVE", "JUMP", "MARK", "MARK_EXACT", "RESTORE", "AGAIN", "AGAIN_COUNT", "AT_LEAST_ONE", "REPEAT", "REPEAT_FAILED",
+                                  "RANGE", "RANGE_END", "EDGE"};
+    const std::vector<std::string> &symbols = grammar.get_symbols();
+    std::string result;
+    size_t rule = 0;
+    for (size_t pc = 0; pc < code.size(); pc++)
+    {
+        while (rule < entries.size() && entries[rule] == pc)
+            result += grammar.get_rules()[rule++].name + ":\n";
+        const Xpp::Instruction &instruction = code[pc];
+        std::string operands;
+        bool fails = true;
+        switch (instruction.op)
+        {
+        case OP_PREDICT:
+        case OP_ALTERNATIVE:
+            operands = "first set " + std::to_string(instruction.a);
+            break;
+        case OP_STRING:
+        case OP_FOLDED:
+        case OP_FOLDED_STRICT:
+            operands = "'";
+            for (char ch : std::string(get_text(instruction.a), instruction.b))
+            {
+                static const char digits[] = "0123456789abcdef";
+                unsigned char byte = static_cast<unsigned char>(ch);
+                if (byte >= 0x20 && byte < 0x7f && ch != '\\' && ch != '\'')
+                    operands += ch;
+                else
+                    operands += std::string("\\x") + digits[byte >> 4] + digits[byte & 15];
+            }
+            operands += "'";
+            break;
+        case OP_CLASS:
+        case OP_NEW_LINE:
+        case OP_EOF:
+        {
+            const Xpp::Repetitions &range = repetitions[instruction.b];
+            operands = symbols[instruction.c] + " {" + std::to_string(range.min) + ":" + (range.max == SIZE_MAX ? std::string("") : std::to_string(range.max)) + "}";
+            break;
+        }
+        case OP_TOKEN:
+        case OP_AT_LEAST_ONE:
+            operands = symbols[instruction.c];
+            break;
+        case OP_CALL:
+            operands = grammar.get_rules()[instruction.a].name;
+            break;
+        case OP_REPEAT_FAILED:
+        case OP_RANGE_END:
+            operands = symbols[instruction.c] + " " + std::to_string(instruction.b) + " times";
+            break;
+        case OP_NO_ALTERNATIVE:
+            break;
+        case OP_EDGE:
+            if (instruction.a & EDGE_SKIP_SPACES)
+                operands = "spaces";
+            if (instruction.a & EDGE_BOUNDARY)
+                operands += operands.empty() ? "boundary" : " boundary";
+            break;
+        case OP_JUMP:
+        case OP_AGAIN:
+        case OP_AGAIN_COUNT:
+            operands = "-> " + std::to_string(instruction.a);
+            fails = false;
+            break;
+        case OP_REPEAT:
+        case OP_RANGE:
+            operands = "-> " + std::to_string(instruction.a) + " " + std::to_string(instruction.b) + " times";
+            fails = false;
+            break;
+        default:
+            fails = false;
+            break;
+        }
+        std::string line = std::to_string(pc);
+        line.insert(0, line.length() < 6 ? 6 - line.length() : 0, ' ');
+        line += "  " + std::string(names[instruction.op]);
+        if (!operands.empty() || fails)
+            line += std::string(16 - std::string(names[instruction.op]).length(), ' ') + operands;
+        if (fails)
+            line += std::string(operands.length() < 32 ? 32 - operands.length() : 1, ' ') + "fail -> " + std::to_string(instruction.fail);
+        result += line + "\n";
+    }
+    return result;
+}
+
+void Xpp::Bytecode::save(Xpp::ImageWriter &writer) const
+{
+    writer.write<uint64_t>(code.size());
+    for (const auto &instruction : code)
+    {
+        writer.write(instruction.op);
+        writer.write(instruction.a);
+        writer.write(instruction.b);
+        writer.write(instruction.c);
+        writer.write(instruction.fail);
+    }
+    writer.write(entries);
+    writer.write(first_sets);
+    writer.write<uint64_t>(repetitions.size());
+    for (const auto &range : repetitions)
+    {
+        writer.write(range.min);
+        writer.write(range.max);
+    }
+    writer.write(text);
+}
+
+void Xpp::Bytecode::load(Xpp::ImageReader &reader)
+{
+    code.resize(reader.read_count());
+    for (auto &instruction : code)
+    {
+        reader.read(instruction.op);
+        reader.read(instruction.a);
+        reader.read(instruction.b);
+        reader.read(instruction.c);
+        reader.read(instruction.fail);
+    }
+    reader.read(entries);
+    reader.read(first_sets);
+    repetitions.resize(reader.read_count());
+    for (auto &range : repetitions)
+    {
+        reader.read(range.min);
+        reader.read(range.max);
+    }
+    reader.read(text);
+}
@@ -0,0 +1,313 @@
+/**
+ * @file engine.cc
+ * @author Simone Ancona
+ * @brief Parsing engine that keeps the rule references on a stack allocated on the heap
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+
+namespace
+{
+    // Where a frame resumes, each step matches the recursive function of the same name
+    enum EngineStep
+    {
+        STEP_EXPRESSION,     // analyze_rule: try the current expression
+        STEP_ELEMENT,        // analyze_expression: match the current element
+        STEP_REFERENCE,      // analyze_alternative and analyze_reference: start the current reference
+        STEP_SINGLE,         // analyze_single_reference: match the current reference once
+        STEP_SINGLE_DONE,    // the quantifier loops: continue after a single match
+        STEP_REFERENCE_DONE, // analyze_alternative: continue after a reference
+        STEP_ELEMENT_DONE,   // analyze_expression: continue after an element
+    };
+
+    // A rule being matched, it replaces a call of analyze_rule
+    struct Frame
+    {
+        const Xpp::Rule *rule;
+        Xpp::AST node;
+        Xpp::Index start;
+        EngineStep step = STEP_EXPRESSION;
+        size_t expression = 0;
+        size_t element = 0;
+        size_t alternative = 0;
+        bool tried = false;
+        Xpp::Index alternative_start = {};
+        Xpp::Index loop_start = {};
+        Xpp::Index loop_index = {};
+        size_t loop_children = 0;
+        size_t count = 0;
+        // The end of the input read by the enclosing rule when the frame was pushed
+        size_t outer_read = 0;
+    };
+};
+
+bool Xpp::Parser::analyze_rule_iterative(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens)
+{
+    std::vector<Frame> frames;
+    bool result = false;
+    frames.push_back(Frame{&grammar->get_rules()[0], std::move(ast), parse_index});
+
+    while (true)
+    {
+        Frame &frame = frames.back();
+        const Xpp::RuleExpression *exp = frame.expression < frame.rule->expressions.size() ? &frame.rule->expressions[frame.expression] : nullptr;
+        switch (frame.step)
+        {
+        case STEP_EXPRESSION:
+            if (exp == nullptr)
+            {
+                if (failures.empty() || !frame.tried)
+                    push_failure(FAILURE_NO_EXPRESSION, *frame.rule);
+                Xpp::Index start = frame.start;
+                size_t outer_read = frame.outer_read;
+                size_t rule_id = frame.rule - grammar->get_rules().data();
+                if (frames.size() == 1)
+                {
+                    ast = std::move(frame.node);
+                    return false;
+                }
+                frames.pop_back();
+                rule_failed(rule_id, start, outer_read);
+                result = false;
+                continue;
+            }
+            if (frame.expression + 1 < frame.rule->expressions.size() && !is_viable(exp->get_first_set(), tokens))
+            {
+                prediction_statistics.expressions_pruned++;
+                frame.expression++;
+                continue;
+            }
+            prediction_statistics.expressions_tried++;
+            frame.tried = true;
+            begin_expression(*frame.rule);
+            frame.element = 0;
+            frame.step = STEP_ELEMENT;
+            continue;
+
+        case STEP_ELEMENT:
+        {
+            if (frame.element == exp->get_elements().size())
+            {
+                if (exp->get_end_edge() != EDGE_NONE && !match_edge(tokens, *frame.rule, exp->get_end_edge(), frame.start.char_index))
+                {
+                    result = false;
+                    frame.step = STEP_ELEMENT_DONE;
+                    continue;
+                }
+                end_expression(*frame.rule, frame.start.char_index, true);
+                Frame done = std::move(frame);
+                frames.pop_back();
+                if (frames.empty())
+                {
+                    ast = std::move(done.node);
+                    return true;
+                }
+                rule_matched(frames.back().node, done.rule - grammar->get_rules().data(), done.start, done.outer_read, std::move(done.node));
+                result = true;
+                continue;
+            }
+            const Xpp::ExpressionElement &el = exp->get_elements()[frame.element];
+            if (el.edge != EDGE_NONE && !match_edge(tokens, *frame.rule, el.edge, frame.start.char_index))
+            {
+                result = false;
+                frame.step = STEP_ELEMENT_DONE;
+                continue;
+            }
+            frame.alternative = 0;
+            frame.alternative_start = parse_index;
+            if (el.type == CONSTANT_TERMINAL)
+            {
+                result = analyze_constant(frame.node, tokens, el, *frame.rule);
+                frame.step = STEP_ELEMENT_DONE;
+                continue;
+            }
+            frame.step = STEP_REFERENCE;
+            continue;
+        }
+
+        case STEP_REFERENCE:
+        {
+            const Xpp::ExpressionElement &el = exp->get_elements()[frame.element];
+            if (el.type == ALTERNATIVE)
+            {
+                parse_index = frame.alternative_start;
+                if (frame.alternative == el.references.size())
+                {
+                    push_failure(FAILURE_ALTERNATIVE, *frame.rule);
+                    result = false;
+                    frame.step = STEP_ELEMENT_DONE;
+                    continue;
+                }
+                if (!is_viable(el.references[frame.alternative].first_set, tokens))
+                {
+                    prediction_statistics.alternatives_pruned++;
+                    frame.alternative++;
+                    continue;
+                }
+                prediction_statistics.alternatives_tried++;
+            }
+
+            const Xpp::ExpressionReference &ref = el.references[frame.alternative];
+            if (ref.kind != REFERENCE_RULE && ref.kind != REFERENCE_TERMINAL)
+            {
+                result = analyze_implicit_terminal(frame.node, tokens, ref, *frame.rule);
+                frame.step = STEP_REFERENCE_DONE;
+                continue;
+            }
+            frame.loop_start = frame.loop_index = parse_index;
+            frame.loop_children = frame.node.get_children().size();
+            frame.count = 0;
+            // Quantifiers that allow no repetition at all never match the reference
+            if ((ref.quantifier.type == EXACT_VALUE && ref.quantifier.x_value == 0) || (ref.quantifier.type == EXACT_RANGE && ref.quantifier.y_value == 0))
+            {
+                result = ref.quantifier.x_value == 0;
+                if (!result)
+                    push_failure(FAILURE_EXACT_RANGE, *frame.rule, ref.symbol, ref.quantifier.x_value);
+                frame.step = STEP_REFERENCE_DONE;
+                continue;
+            }
+            // A failed exact quantifier undoes the repetitions that matched
+            if (events != nullptr && (ref.quantifier.type == EXACT_VALUE || ref.quantifier.type == EXACT_RANGE))
+                events->begin();
+            frame.step = STEP_SINGLE;
+            continue;
+        }
+
+        case STEP_SINGLE:
+        {
+            const Xpp::ExpressionReference &ref = exp->get_elements()[frame.element].references[frame.alternative];
+            frame.step = STEP_SINGLE_DONE;
+            if (ref.kind == REFERENCE_TERMINAL)
+            {
+                result = analyze_single_reference(frame.node, tokens, ref, *frame.rule);
+                continue;
+            }
+            if (!spend_step())
+            {
+                result = false;
+                continue;
+            }
+            if (reuse_rule(frame.node, tokens, ref.id))
+            {
+                result = true;
+                continue;
+            }
+            if (replay_rule(frame.node, ref.id, result))
+                continue;
+            // The reference to frame is no longer valid once the new frame is pushed
+            const Xpp::Rule *rule = &grammar->get_rules()[ref.id];
+            Xpp::AST node = events != nullptr ? Xpp::AST() : Xpp::AST(rule->name, std::vector<Xpp::AST>{});
+            node.set_span(parse_index.char_index, 0, 0);
+            frames.push_back(Frame{rule, std::move(node), parse_index});
+            frames.back().outer_read = read_end;
+            read_end = parse_index.char_index;
+            continue;
+        }
+
+        case STEP_SINGLE_DONE:
+        {
+            const Xpp::ExpressionReference &ref = exp->get_elements()[frame.element].references[frame.alternative];
+            frame.step = STEP_REFERENCE_DONE;
+            switch (ref.quantifier.type)
+            {
+            case NONE:
+                break;
+            case ZERO_OR_ONE:
+                result = true;
+                break;
+            case ZERO_OR_MORE:
+                if (result && parse_index.char_index != frame.loop_index.char_index)
+                {
+                    frame.loop_index = parse_index;
+                    frame.step = STEP_SINGLE;
+                    break;
+                }
+                parse_index = frame.loop_index;
+                result = true;
+                break;
+            case ONE_OR_MORE:
+                if (result)
+                {
+                    frame.count++;
+                    if (parse_index.char_index != frame.loop_index.char_index)
+                    {
+                        frame.loop_index = parse_index;
+                        frame.step = STEP_SINGLE;
+                        break;
+                    }
+                }
+                parse_index = frame.loop_index;
+                result = frame.count != 0;
+                if (!result)
+                    push_failure(FAILURE_ONE_OR_MORE, *frame.rule, ref.symbol);
+                break;
+            case EXACT_VALUE:
+                if (!result)
+                {
+                    if (events != nullptr)
+                        events->rollback();
+                    backtrack(frame.node, frame.loop_start, frame.loop_children);
+                    push_failure(FAILURE_EXACT_VALUE, *frame.rule, ref.symbol, ref.quantifier.x_value);
+                    break;
+                }
+                if (++frame.count < ref.quantifier.x_value)
+                    frame.step = STEP_SINGLE;
+                else if (events != nullptr)
+                    events->commit();
+                break;
+            case EXACT_RANGE:
+                if (result)
+                {
+                    frame.loop_index = parse_index;
+                    if (++frame.count < ref.quantifier.y_value)
+                    {
+                        frame.step = STEP_SINGLE;
+                        break;
+                    }
+                }
+                parse_index = frame.loop_index;
+                result = frame.count >= ref.quantifier.x_value;
+                if (events != nullptr && result)
+                    events->commit();
+                if (!result)
+                {
+                    if (events != nullptr)
+                        events->rollback();
+                    backtrack(frame.node, frame.loop_start, frame.loop_children);
+                    push_failure(FAILURE_EXACT_RANGE, *frame.rule, ref.symbol, ref.quantifier.x_value);
+                }
+                break;
+            }
+            continue;
+        }
+
+        case STEP_REFERENCE_DONE:
+            if (exp->get_elements()[frame.element].type == ALTERNATIVE && !result)
+            {
+                frame.alternative++;
+                frame.step = STEP_REFERENCE;
+                continue;
+            }
+            frame.step = STEP_ELEMENT_DONE;
+            continue;
+
+        case STEP_ELEMENT_DONE:
+            if (result)
+            {
+                frame.element++;
+                frame.step = STEP_ELEMENT;
+                continue;
+            }
+            end_expression(*frame.rule, frame.start.char_index, false);
+            backtrack(frame.node, frame.start, 0);
+            frame.expression++;
+            frame.step = STEP_EXPRESSION;
+            continue;
+        }
+    }
+}
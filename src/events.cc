@@ -0,0 +1,74 @@
+/**
+ * @file events.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "events.hh"
+
+Xpp::EventBuffer::EventBuffer(Xpp::EventHandler &handler) : target(handler) {}
+
+void Xpp::EventBuffer::forward(const Event &event)
+{
+    switch (event.kind)
+    {
+    case EVENT_ENTER:
+        target.enter_rule(*event.rule, event.offset);
+        break;
+    case EVENT_EXIT:
+        target.exit_rule(*event.rule, event.span);
+        break;
+    case EVENT_TERMINAL:
+        target.terminal(*event.rule, event.span);
+        break;
+    }
+}
+
+void Xpp::EventBuffer::enter_rule(const Xpp::Rule &rule, size_t offset)
+{
+    if (attempts.empty())
+        target.enter_rule(rule, offset);
+    else
+        events.push_back({EVENT_ENTER, &rule, {}, offset});
+}
+
+void Xpp::EventBuffer::exit_rule(const Xpp::Rule &rule, std::string_view span)
+{
+    if (attempts.empty())
+        target.exit_rule(rule, span);
+    else
+        events.push_back({EVENT_EXIT, &rule, span, 0});
+}
+
+void Xpp::EventBuffer::terminal(const Xpp::Rule &rule, std::string_view span)
+{
+    if (attempts.empty())
+        target.terminal(rule, span);
+    else
+        events.push_back({EVENT_TERMINAL, &rule, span, 0});
+}
+
+void Xpp::EventBuffer::begin()
+{
+    attempts.push_back(events.size());
+}
+
+void Xpp::EventBuffer::commit()
+{
+    attempts.pop_back();
+    if (!attempts.empty())
+        return;
+    for (const Event &event : events)
+        forward(event);
+    events.clear();
+}
+
+void Xpp::EventBuffer::rollback()
+{
+    events.resize(attempts.back());
+    attempts.pop_back();
+}
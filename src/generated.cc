@@ -0,0 +1,102 @@
+/**
+ * @file generated.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "generated.hh"
+
+Xpp::GeneratedParser::GeneratedParser(const std::vector<Xpp::TerminalRule> &terminals, const std::string &root_rule) : lexer(terminals), root(root_rule) {}
+
+Xpp::AST Xpp::GeneratedParser::generate_ast(const std::string &input_string)
+{
+    Xpp::ParseResult result = try_generate_ast(input_string);
+    if (!result.success)
+        throw Xpp::SyntaxErrorException("An error occurred while parsing the string:\n\t" + result.error.message);
+    return std::move(result.ast);
+}
+
+Xpp::AST Xpp::GeneratedParser::generate_ast(std::string_view input_string)
+{
+    Xpp::ParseResult result = try_generate_ast(input_string);
+    if (!result.success)
+        throw Xpp::SyntaxErrorException("An error occurred while parsing the string:\n\t" + result.error.message);
+    return std::move(result.ast);
+}
+
+Xpp::AST Xpp::GeneratedParser::generate_ast(const char *input_string)
+{
+    return generate_ast(std::string_view(input_string));
+}
+
+Xpp::ParseResult Xpp::GeneratedParser::try_generate_ast(const std::string &input_string)
+{
+    std::shared_ptr<const Xpp::Source> owned = Xpp::Source::from_string(input_string);
+    return parse(owned, owned->get_view());
+}
+
+Xpp::ParseResult Xpp::GeneratedParser::try_generate_ast(std::string_view input_string)
+{
+    return parse(nullptr, input_string);
+}
+
+Xpp::ParseResult Xpp::GeneratedParser::try_generate_ast(const char *input_string)
+{
+    return try_generate_ast(std::string_view(input_string));
+}
+
+Xpp::ParseResult Xpp::GeneratedParser::parse(std::shared_ptr<const Xpp::Source> input_source, std::string_view input_string)
+{
+    source = std::move(input_source);
+    input = input_string;
+    lines.assign(input);
+    lexer.tokenize(input, tokens);
+    index = {0, 0};
+    failed = false;
+    last_failure_offset = 0;
+
+    Xpp::AST ast(root, std::vector<Xpp::AST>{});
+    if (!parse_root(ast))
+        return {false, Xpp::AST(), describe_failure(farthest)};
+    ast.set_span(0, index.char_index, 0);
+    return {true, std::move(ast), {}};
+}
+
+Xpp::SyntaxError Xpp::GeneratedParser::describe_failure(const GeneratedFailure &failure) const
+{
+    return Xpp::format_failure(failure.kind, *failure.rule, failure.text != nullptr ? failure.text : "", failure.count, failure.offset, lines);
+}
+
+bool Xpp::GeneratedParser::folded_constant(Xpp::AST &ast, const std::string &rule, const char *folded, const char *value, size_t length, bool strict)
+{
+    size_t char_index = index.char_index;
+    if (input.length() - char_index < length || !Xpp::Scanner::equals_folded(input.data() + char_index, folded, length, strict))
+    {
+        fail(FAILURE_FOLDED_CONSTANT, rule, value);
+        return false;
+    }
+    advance_to(char_index + length);
+    terminal_node(ast, rule, char_index, length);
+    return true;
+}
+
+bool Xpp::GeneratedParser::implicit_terminal(Xpp::AST &ast, const std::string &rule, Xpp::ReferenceKind kind, size_t id, size_t min, size_t max, const char *symbol)
+{
+    size_t char_index = index.char_index;
+    Xpp::ImplicitMatch match = Xpp::scan_implicit_terminal(kind, id, min, max, input.substr(char_index));
+    if (match.count < min)
+    {
+        fail(FAILURE_REFERENCE, rule, symbol);
+        return false;
+    }
+    if (match.length > 0)
+    {
+        terminal_node(ast, rule, char_index, match.length);
+        advance_to(char_index + match.length);
+    }
+    return true;
+}
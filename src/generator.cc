@@ -0,0 +1,260 @@
+/**
+ * @file generator.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "generator.hh"
+#include <algorithm>
+#include <cstdint>
+
+Xpp::CodeGenerator::CodeGenerator(const Xpp::CompiledGrammar &grammar, const std::string &class_name) : grammar(grammar), class_name(class_name) {}
+
+std::string Xpp::CodeGenerator::literal(const std::string &value)
+{
+    static const char digits[] = "01234567";
+    std::string result = "\"";
+    for (char ch : value)
+    {
+        unsigned char byte = static_cast<unsigned char>(ch);
+        if (ch == '"' || ch == '\\')
+        {
+            result += '\\';
+            result += ch;
+        }
+        else if (byte >= 0x20 && byte < 0x7f && ch != '?')
+            result += ch;
+        else
+        {
+            // Octal escapes have at most 3 digits, so the next character is never read as part of them
+            result += '\\';
+            result += digits[byte >> 6];
+            result += digits[(byte >> 3) & 7];
+            result += digits[byte & 7];
+        }
+    }
+    return result + "\"";
+}
+
+size_t Xpp::CodeGenerator::terminal_words() const noexcept
+{
+    return std::max<size_t>(1, (grammar.get_terminals().size() + 63) / 64);
+}
+
+std::string Xpp::CodeGenerator::add_first_set(const Xpp::FirstSet &set)
+{
+    std::string name = "first_" + std::to_string(first_sets.size());
+    std::string bytes;
+    for (size_t word = 0; word < 4; word++)
+    {
+        uint64_t bits = 0;
+        for (size_t bit = 0; bit < 64; bit++)
+        {
+            if (set.bytes[word * 64 + bit])
+                bits |= uint64_t(1) << bit;
+        }
+        bytes += (word == 0 ? "" : ", ") + std::to_string(bits) + "ull";
+    }
+    std::string terminals;
+    for (size_t word = 0; word < terminal_words(); word++)
+    {
+        uint64_t bits = 0;
+        for (size_t bit = 0; bit < 64 && word * 64 + bit < set.terminals.size(); bit++)
+        {
+            if (set.terminals[word * 64 + bit])
+                bits |= uint64_t(1) << bit;
+        }
+        terminals += (word == 0 ? "" : ", ") + std::to_string(bits) + "ull";
+    }
+    std::string value = "{{" + bytes + "}, " + (set.end ? "true" : "false") + ", " + (set.tokens_only ? "true" : "false") + ", {" + terminals + "}}";
+    // Equal sets share a table
+    auto found = std::find(first_sets.begin(), first_sets.end(), value);
+    if (found != first_sets.end())
+        return "first_" + std::to_string(found - first_sets.begin());
+    first_sets.push_back(value);
+    return name;
+}
+
+std::string Xpp::CodeGenerator::viability(const Xpp::FirstSet &set)
+{
+    // A nullable match cannot be predicted, so it is always tried
+    if (set.nullable)
+        return "";
+    return "viable(" + add_first_set(set) + ")";
+}
+
+std::string Xpp::CodeGenerator::reference(const Xpp::ExpressionReference &ref, size_t rule)
+{
+    std::string rule_name = "rule_names[" + std::to_string(rule) + "]";
+    std::string symbol = literal(grammar.get_symbols()[ref.symbol]);
+    const Xpp::Quantifier &quantifier = ref.quantifier;
+    if (ref.kind != REFERENCE_RULE && ref.kind != REFERENCE_TERMINAL)
+    {
+        size_t min = 1;
+        size_t max = 1;
+        switch (quantifier.type)
+        {
+        case NONE:
+            break;
+        case ZERO_OR_ONE:
+            min = 0;
+            break;
+        case ZERO_OR_MORE:
+            min = 0;
+            max = SIZE_MAX;
+            break;
+        case ONE_OR_MORE:
+            max = SIZE_MAX;
+            break;
+        case EXACT_VALUE:
+            min = max = quantifier.x_value;
+            break;
+        case EXACT_RANGE:
+            min = quantifier.x_value;
+            max = quantifier.y_value;
+            break;
+        }
+        static const char *kinds[] = {"Xpp::REFERENCE_RULE", "Xpp::REFERENCE_TERMINAL", "Xpp::REFERENCE_CLASS", "Xpp::REFERENCE_NEW_LINE", "Xpp::REFERENCE_EOF"};
+        return "implicit_terminal(ast, " + rule_name + ", " + kinds[ref.kind] + ", " + std::to_string(ref.id) + ", " + std::to_string(min) + "ull, " +
+               (max == SIZE_MAX ? std::string("SIZE_MAX") : std::to_string(max) + "ull") + ", " + symbol + ")";
+    }
+
+    std::string single = ref.kind == REFERENCE_TERMINAL ? "token(ast, " + rule_name + ", " + std::to_string(ref.id) + ", " + symbol + ")"
+                                                        : "reference_" + std::to_string(ref.id) + "(ast)";
+    std::string lambda = "[&]\n            { return " + single + "; }";
+    switch (quantifier.type)
+    {
+    case NONE:
+        return single;
+    case ZERO_OR_ONE:
+        return "zero_or_one(" + lambda + ")";
+    case ZERO_OR_MORE:
+        return "zero_or_more(" + lambda + ")";
+    case ONE_OR_MORE:
+        return "one_or_more(" + lambda + ", " + rule_name + ", " + symbol + ")";
+    case EXACT_VALUE:
+        return "exact_value(ast, " + lambda + ", " + std::to_string(quantifier.x_value) + ", " + rule_name + ", " + symbol + ")";
+    case EXACT_RANGE:
+        return "exact_range(ast, " + lambda + ", " + std::to_string(quantifier.x_value) + ", " + std::to_string(quantifier.y_value) + ", " + rule_name + ", " + symbol + ")";
+    }
+    return single;
+}
+
+std::string Xpp::CodeGenerator::element(const Xpp::ExpressionElement &el, size_t rule)
+{
+    std::string rule_name = "rule_names[" + std::to_string(rule) + "]";
+    switch (el.type)
+    {
+    case CONSTANT_TERMINAL:
+        if (el.case_insensitive != CASE_INSENSITIVE_CLEAR)
+            return "    if (!folded_constant(ast, " + rule_name + ", " + literal(el.folded_value) + ", " + literal(el.value) + ", " + std::to_string(el.value.length()) + ", " +
+                   (el.case_insensitive == CASE_INSENSITIVE_STRICT ? "true" : "false") + "))\n        return false;\n";
+        return "    if (!constant(ast, " + rule_name + ", " + literal(el.value) + ", " + std::to_string(el.value.length()) + "))\n        return false;\n";
+    case RULE_REFERENCE:
+        return "    if (!" + reference(el.references[0], rule) + ")\n        return false;\n";
+    case ALTERNATIVE:
+        break;
+    }
+
+    std::string code = "    {\n        Xpp::Index alternative_start = index;\n        bool matched = false;\n";
+    for (const auto &ref : el.references)
+    {
+        std::string condition = viability(ref.first_set);
+        code += "        if (!matched)\n        {\n            index = alternative_start;\n";
+        code += "            matched = " + (condition.empty() ? "" : condition + " && ") + reference(ref, rule) + ";\n        }\n";
+    }
+    code += "        if (!matched)\n        {\n            index = alternative_start;\n";
+    code += "            fail(Xpp::FAILURE_ALTERNATIVE, " + rule_name + ", nullptr);\n            return false;\n        }\n    }\n";
+    return code;
+}
+
+std::string Xpp::CodeGenerator::edge(int flags, size_t rule)
+{
+    std::string code;
+    if (flags & EDGE_SKIP_SPACES)
+        code += "    skip_spaces();\n";
+    if (flags & EDGE_BOUNDARY)
+        code += "    if (!boundary(rule_names[" + std::to_string(rule) + "], start))\n        return false;\n";
+    return code;
+}
+
+std::string Xpp::CodeGenerator::expression_function(size_t rule, size_t expression)
+{
+    const Xpp::RuleExpression &exp = grammar.get_rules()[rule].expressions[expression];
+    std::string code = "bool " + class_name + "::expression_" + std::to_string(rule) + "_" + std::to_string(expression) + "(Xpp::AST &ast)\n{\n";
+    if (exp.get_end_edge() & EDGE_BOUNDARY)
+        code += "    size_t start = index.char_index;\n";
+    for (const auto &el : exp.get_elements())
+        code += edge(el.edge, rule) + element(el, rule);
+    return code + edge(exp.get_end_edge(), rule) + "    return true;\n}\n\n";
+}
+
+std::string Xpp::CodeGenerator::rule_function(size_t rule)
+{
+    const Xpp::Rule &target = grammar.get_rules()[rule];
+    std::string id = std::to_string(rule);
+    std::string code = "// " + target.name + "\nbool " + class_name + "::rule_" + id + "(Xpp::AST &ast)\n{\n";
+    code += "    Xpp::Index start = index;\n    size_t children = ast.get_children().size();\n    bool tried = false;\n";
+    for (size_t i = 0; i < target.expressions.size(); i++)
+    {
+        std::string condition = i + 1 == target.expressions.size() ? "" : viability(target.expressions[i].get_first_set());
+        code += condition.empty() ? "    {\n" : "    if (" + condition + ")\n    {\n";
+        code += "        tried = true;\n        if (expression_" + id + "_" + std::to_string(i) + "(ast))\n            return true;\n";
+        code += "        backtrack(ast, start, children);\n    }\n";
+    }
+    code += "    if (!has_failed() || !tried)\n        fail(Xpp::FAILURE_NO_EXPRESSION, rule_names[" + id + "], nullptr);\n    return false;\n}\n\n";
+
+    code += "bool " + class_name + "::reference_" + id + "(Xpp::AST &ast)\n{\n    Xpp::Index start = index;\n";
+    code += "    Xpp::AST child(rule_names[" + id + "], std::vector<Xpp::AST>{});\n    child.set_span(start.char_index, 0, 0);\n";
+    code += "    if (!rule_" + id + "(child))\n    {\n        rule_failed(rule_names[" + id + "], start);\n        return false;\n    }\n";
+    code += "    rule_matched(ast, std::move(child), start);\n    return true;\n}\n\n";
+
+    for (size_t i = 0; i < target.expressions.size(); i++)
+        code += expression_function(rule, i);
+    return code;
+}
+
+std::string Xpp::CodeGenerator::generate_header()
+{
+    std::string code = "// Generated by xparse-gen, do not edit\n\n#pragma once\n\n#include \"generated.hh\"\n\n";
+    code += "class " + class_name + " : public Xpp::GeneratedParser\n{\nprivate:\n    bool parse_root(Xpp::AST &) override;\n";
+    const std::vector<Xpp::Rule> &rules = grammar.get_rules();
+    for (size_t i = 0; i < rules.size(); i++)
+    {
+        std::string id = std::to_string(i);
+        code += "    bool rule_" + id + "(Xpp::AST &);\n    bool reference_" + id + "(Xpp::AST &);\n";
+        for (size_t j = 0; j < rules[i].expressions.size(); j++)
+            code += "    bool expression_" + id + "_" + std::to_string(j) + "(Xpp::AST &);\n";
+    }
+    return code + "\npublic:\n    " + class_name + "();\n};\n";
+}
+
+std::string Xpp::CodeGenerator::generate_source(const std::string &header)
+{
+    first_sets.clear();
+    const std::vector<Xpp::Rule> &rules = grammar.get_rules();
+    std::string functions;
+    for (size_t i = 0; i < rules.size(); i++)
+        functions += rule_function(i);
+
+    std::string code = "// Generated by xparse-gen, do not edit\n\n#include \"" + header + "\"\n\nnamespace\n{\n";
+    code += "    const std::string rule_names[] = {";
+    for (size_t i = 0; i < rules.size(); i++)
+        code += (i == 0 ? "" : ", ") + literal(rules[i].name);
+    code += "};\n\n";
+    for (size_t i = 0; i < first_sets.size(); i++)
+        code += "    constexpr Xpp::GeneratedFirstSet<" + std::to_string(terminal_words()) + "> first_" + std::to_string(i) + " = " + first_sets[i] + ";\n";
+    code += "};\n\n";
+
+    code += class_name + "::" + class_name + "() : Xpp::GeneratedParser({";
+    const std::vector<Xpp::TerminalRule> &terminals = grammar.get_terminals();
+    for (size_t i = 0; i < terminals.size(); i++)
+        code += std::string(i == 0 ? "" : ", ") + "{" + literal(terminals[i].name) + ", " + literal(terminals[i].regex) + "}";
+    code += "}, " + literal(rules[0].name) + ") {}\n\n";
+    code += "bool " + class_name + "::parse_root(Xpp::AST &ast)\n{\n    return rule_0(ast);\n}\n\n";
+    return code + functions;
+}
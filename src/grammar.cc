@@ -0,0 +1,386 @@
+/**
+ * @file grammar.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "grammar.hh"
+#include "image.hh"
+#include "source.hh"
+
+Xpp::CompiledGrammar::CompiledGrammar(const Jpp::Json &grammar)
+{
+    this->grammar = grammar;
+    this->generate_from_json();
+}
+
+Xpp::CompiledGrammar::CompiledGrammar(const std::string &grammar)
+{
+    this->grammar.parse(grammar);
+    this->generate_from_json();
+}
+
+Xpp::CompiledGrammar::CompiledGrammar(const std::ifstream &file)
+{
+    this->grammar.parse(this->get_string_from_file(file));
+    this->generate_from_json();
+}
+
+std::string Xpp::CompiledGrammar::get_string_from_file(const std::ifstream &file)
+{
+    std::stringstream buff;
+    buff << file.rdbuf();
+    return buff.str();
+}
+
+void Xpp::CompiledGrammar::generate_from_json()
+{
+    auto children = grammar.get_children();
+    auto terminals = children.find("terminals");
+    if (terminals == children.end())
+        throw std::runtime_error("The 'terminals' property is required in the JSON grammar.");
+    auto rules = children.find("rules");
+    if (rules == children.end())
+        throw std::runtime_error("The 'rules' property is required in the JSON grammar.");
+
+    if (!terminals->second.is_array())
+        throw std::runtime_error("The 'terminals' property must be an array");
+    if (!rules->second.is_array())
+        throw std::runtime_error("The 'rules' property must be an array");
+
+    auto terminalsArray = terminals->second.get_children();
+    auto rulesArray = rules->second.get_children();
+
+    generate_terminal_rules(terminalsArray);
+    generate_rules(rulesArray);
+    compile_terminal_rules();
+    compile_constants();
+    compute_first_sets();
+    bytecode = Bytecode(*this);
+}
+
+std::vector<Jpp::Json> Xpp::CompiledGrammar::get_array_elements(const std::map<std::string, Jpp::Json> &array)
+{
+    // JSON arrays are stored in a map keyed by the index as a string, so "10" would come before "2"
+    std::vector<Jpp::Json> elements;
+    elements.reserve(array.size());
+    for (size_t i = 0; i < array.size(); i++)
+        elements.push_back(array.at(std::to_string(i)));
+    return elements;
+}
+
+void Xpp::CompiledGrammar::generate_terminal_rules(const std::map<std::string, Jpp::Json> &terminalsArray)
+{
+    // User-defined terminals are tried before the predefined ones, in the order they are written
+    size_t position = 0;
+    for (auto terminal : get_array_elements(terminalsArray))
+    {
+        try
+        {
+            this->terminals.insert(this->terminals.begin() + position++, Xpp::TerminalRule{std::any_cast<std::string>(terminal["name"].get_value()), std::any_cast<std::string>(terminal["regex"].get_value())});
+        }
+        catch (const std::runtime_error e)
+        {
+            throw std::runtime_error("Error while parsing the array of terminals, go to https://github.com/SimoneAncona/xparser#define-a-grammar for more");
+        }
+    }
+}
+
+void Xpp::CompiledGrammar::compile_terminal_rules()
+{
+    lexer = Xpp::Lexer(terminals);
+}
+
+void Xpp::CompiledGrammar::compile_constants()
+{
+    for (auto &rule : rules)
+    {
+        for (auto &exp : rule.expressions)
+        {
+            int case_insensitive = exp.is_strict_case_insensitive_set() ? CASE_INSENSITIVE_STRICT : exp.is_soft_case_insensitive_set() ? CASE_INSENSITIVE_SOFT
+                                                                                                                                      : CASE_INSENSITIVE_CLEAR;
+            for (auto &el : exp.get_elements())
+            {
+                if (el.type != CONSTANT_TERMINAL)
+                    continue;
+                el.case_insensitive = case_insensitive;
+                el.constant_id = constants.add(el.value);
+                if (case_insensitive != CASE_INSENSITIVE_CLEAR)
+                    el.folded_value = Scanner::fold(el.value);
+            }
+        }
+    }
+    constants.build();
+}
+
+void Xpp::CompiledGrammar::compute_first_sets()
+{
+    // Rules can reference each other, so the sets only grow until none of them changes
+    bool changed = true;
+    rule_first_sets.assign(rules.size(), FirstSet{});
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 0; i < rules.size(); i++)
+        {
+            FirstSet rule_set;
+            for (auto &exp : rules[i].expressions)
+            {
+                exp.get_first_set() = expression_first_set(exp);
+                rule_set.merge(exp.get_first_set());
+            }
+            if (!(rule_set == rule_first_sets[i]))
+            {
+                rule_first_sets[i] = rule_set;
+                changed = true;
+            }
+        }
+    }
+}
+
+Xpp::FirstSet Xpp::CompiledGrammar::expression_first_set(Xpp::RuleExpression &exp)
+{
+    FirstSet set;
+    FirstSet element_set;
+    // The references of every element need their sets for prediction, even after the first non-nullable one
+    bool nullable_prefix = true;
+    for (auto &el : exp.get_elements())
+    {
+        // The spaces skipped before the element can start the match
+        if (nullable_prefix && (el.edge & EDGE_SKIP_SPACES))
+        {
+            FirstSet spaces;
+            for (size_t byte = 0; byte < 256; byte++)
+                spaces.bytes[byte] = Scanner::is_in_class(CLASS_SPACE, static_cast<char>(byte));
+            set.merge(spaces);
+        }
+        element_set = FirstSet{};
+        if (el.type == CONSTANT_TERMINAL)
+        {
+            element_set.nullable = el.value.empty();
+            if (!el.value.empty())
+            {
+                unsigned char first = static_cast<unsigned char>(el.value[0]);
+                element_set.bytes[first] = true;
+                if (el.case_insensitive != CASE_INSENSITIVE_CLEAR && std::isalpha(first))
+                    element_set.bytes[first ^ 0x20] = true;
+            }
+        }
+        for (auto &ref : el.references)
+        {
+            ref.first_set = reference_first_set(ref);
+            element_set.merge(ref.first_set);
+        }
+
+        if (!nullable_prefix)
+            continue;
+        nullable_prefix = element_set.nullable;
+        element_set.nullable = false;
+        set.merge(element_set);
+    }
+    set.nullable = nullable_prefix;
+    return set;
+}
+
+Xpp::FirstSet Xpp::CompiledGrammar::reference_first_set(Xpp::ExpressionReference &ref)
+{
+    FirstSet set;
+    switch (ref.kind)
+    {
+    case REFERENCE_RULE:
+        set = rule_first_sets[ref.id];
+        break;
+    case REFERENCE_TERMINAL:
+        set.bytes = lexer.get_matchers()[ref.id].get_first_bytes();
+        set.terminals.assign(terminals.size(), false);
+        set.terminals[ref.id] = true;
+        set.tokens_only = true;
+        break;
+    case REFERENCE_CLASS:
+        for (size_t byte = 0; byte < 256; byte++)
+            set.bytes[byte] = Scanner::is_in_class(static_cast<CharacterClass>(ref.id), static_cast<char>(byte));
+        break;
+    case REFERENCE_NEW_LINE:
+        set.bytes['\n'] = set.bytes['\r'] = true;
+        break;
+    case REFERENCE_EOF:
+        set.end = true;
+        break;
+    }
+
+    switch (ref.quantifier.type)
+    {
+    case ZERO_OR_ONE:
+    case ZERO_OR_MORE:
+        set.nullable = true;
+        break;
+    case EXACT_VALUE:
+    case EXACT_RANGE:
+        set.nullable = set.nullable || ref.quantifier.x_value == 0;
+        break;
+    default:
+        break;
+    }
+    return set;
+}
+
+void Xpp::CompiledGrammar::generate_rules(const std::map<std::string, Jpp::Json> &rulesArray)
+{
+    std::string rule_name;
+    for (auto ruleJSON : get_array_elements(rulesArray))
+    {
+        try
+        {
+            rule_name = std::any_cast<std::string>(ruleJSON["name"].get_value());
+            this->rules.push_back(Xpp::Rule{rule_name, parse_expressions(ruleJSON["expressions"].get_children())});
+        }
+        catch (const std::runtime_error e)
+        {
+            throw std::runtime_error("Error while parsing the array of rules, go to https://github.com/SimoneAncona/xparser#define-a-grammar for more:\n\t" + std::string(e.what()));
+        }
+    }
+
+    // Rules are never added after this point, so references can be resolved to indices in the vectors
+    for (auto &rule : rules)
+    {
+        for (auto &exp : rule.expressions)
+        {
+            for (auto &el : exp.get_elements())
+            {
+                for (auto &ref : el.references)
+                    resolve_reference(ref, rule.name);
+            }
+        }
+    }
+
+    if (rules.size() == 0)
+        throw std::runtime_error("No rules were specified. You must specify at least one rule");
+}
+
+std::vector<Xpp::RuleExpression> Xpp::CompiledGrammar::parse_expressions(const std::map<std::string, Jpp::Json> &expressions)
+{
+    std::vector<Xpp::RuleExpression> parsed_expressions;
+    Xpp::RuleExpression temp_expression;
+
+    for (auto exp : get_array_elements(expressions))
+    {
+        temp_expression = Xpp::RuleExpression(any_cast<std::string>(exp.get_value()));
+        parsed_expressions.push_back(temp_expression);
+    }
+
+    return parsed_expressions;
+}
+
+void Xpp::CompiledGrammar::resolve_reference(Xpp::ExpressionReference &ref, const std::string &rule_name)
+{
+    Xpp::CharacterClass cls;
+    if (Xpp::Rule *rule = find_rule(ref.reference_to))
+    {
+        ref.kind = REFERENCE_RULE;
+        ref.id = rule - rules.data();
+    }
+    else if (Xpp::TerminalRule *terminal = find_terminal_rule(ref.reference_to))
+    {
+        ref.kind = REFERENCE_TERMINAL;
+        ref.id = terminal - terminals.data();
+    }
+    else if (Xpp::Scanner::get_class(ref.reference_to, cls))
+    {
+        ref.kind = REFERENCE_CLASS;
+        ref.id = cls;
+    }
+    else if (ref.reference_to == "newLine")
+        ref.kind = REFERENCE_NEW_LINE;
+    else if (ref.reference_to == "eof")
+        ref.kind = REFERENCE_EOF;
+    else
+        throw std::runtime_error("Undefined reference to the rule '" + ref.reference_to + "' in the rule '" + rule_name + "'");
+    ref.symbol = get_symbol(ref.reference_to);
+}
+
+Xpp::Rule *Xpp::CompiledGrammar::find_rule(const std::string &name)
+{
+    for (auto &rule : rules)
+    {
+        if (rule.name == name)
+            return &rule;
+    }
+    return nullptr;
+}
+
+Xpp::TerminalRule *Xpp::CompiledGrammar::find_terminal_rule(const std::string &name)
+{
+    for (auto &t : terminals)
+    {
+        if (t.name == name)
+            return &t;
+    }
+    return nullptr;
+}
+
+size_t Xpp::CompiledGrammar::get_symbol(const std::string &name)
+{
+    auto found = std::find(symbols.begin(), symbols.end(), name);
+    if (found != symbols.end())
+        return found - symbols.begin();
+    symbols.push_back(name);
+    return symbols.size() - 1;
+}
+
+void Xpp::CompiledGrammar::save(const std::string &path) const
+{
+    Xpp::ImageWriter writer;
+    writer.write<uint64_t>(terminals.size());
+    for (const auto &terminal : terminals)
+    {
+        writer.write(terminal.name);
+        writer.write(terminal.regex);
+    }
+    lexer.save(writer);
+    writer.write<uint64_t>(rules.size());
+    for (const auto &rule : rules)
+    {
+        writer.write(rule.name);
+        writer.write(rule.expressions);
+    }
+    writer.write(constants);
+    writer.write(rule_first_sets);
+    writer.write(symbols);
+    writer.write(bytecode);
+
+    std::string image = writer.get_image();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(image.data(), image.size()) || !file.flush())
+        throw std::runtime_error("Cannot write the compiled grammar to the file: " + path);
+}
+
+std::shared_ptr<const Xpp::CompiledGrammar> Xpp::CompiledGrammar::load(const std::string &path)
+{
+    std::shared_ptr<const Xpp::Source> image = Xpp::Source::map_file(path);
+    Xpp::ImageReader reader(image->get_view());
+    std::shared_ptr<Xpp::CompiledGrammar> grammar(new Xpp::CompiledGrammar());
+    grammar->terminals.resize(reader.read_count());
+    for (auto &terminal : grammar->terminals)
+    {
+        reader.read(terminal.name);
+        reader.read(terminal.regex);
+    }
+    grammar->lexer.load(reader, grammar->terminals);
+    grammar->rules.resize(reader.read_count());
+    for (auto &rule : grammar->rules)
+    {
+        reader.read(rule.name);
+        reader.read(rule.expressions);
+    }
+    reader.read(grammar->constants);
+    reader.read(grammar->rule_first_sets);
+    reader.read(grammar->symbols);
+    reader.read(grammar->bytecode);
+    if (!reader.at_end() || grammar->rules.empty())
+        throw std::runtime_error("The compiled grammar has a wrong layout");
+    return grammar;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file image.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "image.hh"
+
+namespace
+{
+    // FNV-1a, the checksum only has to detect damaged and truncated files
+    uint64_t checksum(const char *data, size_t length)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+};
+
+void Xpp::ImageWriter::write(const std::string &value)
+{
+    write<uint64_t>(value.length());
+    payload += value;
+}
+
+void Xpp::ImageWriter::write(const std::bitset<256> &bits)
+{
+    for (size_t word = 0; word < 4; word++)
+    {
+        uint64_t value = 0;
+        for (size_t bit = 0; bit < 64; bit++)
+        {
+            if (bits[word * 64 + bit])
+                value |= uint64_t(1) << bit;
+        }
+        write(value);
+    }
+}
+
+void Xpp::ImageWriter::write(const Xpp::FirstSet &set)
+{
+    write(set.bytes);
+    std::vector<uint8_t> terminals(set.terminals.begin(), set.terminals.end());
+    write(terminals);
+    write(set.tokens_only);
+    write(set.nullable);
+    write(set.end);
+}
+
+std::string Xpp::ImageWriter::get_image() const
+{
+    Xpp::ImageHeader header;
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_VERSION;
+    header.marker = IMAGE_MARKER;
+    header.length = payload.length();
+    header.checksum = checksum(payload.data(), payload.length());
+    return std::string(reinterpret_cast<const char *>(&header), sizeof(header)) + payload;
+}
+
+Xpp::ImageReader::ImageReader(std::string_view image)
+{
+    Xpp::ImageHeader header;
+    if (image.length() < sizeof(header))
+        throw std::runtime_error("The file is not a compiled grammar");
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (std::memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("The file is not a compiled grammar");
+    if (header.version != IMAGE_VERSION)
+        throw std::runtime_error("The compiled grammar has version " + std::to_string(header.version) + ", this library reads version " + std::to_string(IMAGE_VERSION));
+    if (header.marker != IMAGE_MARKER)
+        throw std::runtime_error("The compiled grammar was saved on a machine with a different byte order or word size");
+    if (header.length != image.length() - sizeof(header))
+        throw std::runtime_error("The compiled grammar is truncated");
+    data = image.data() + sizeof(header);
+    length = header.length;
+    if (checksum(data, length) != header.checksum)
+        throw std::runtime_error("The checksum of the compiled grammar does not match, the file is damaged");
+}
+
+const char *Xpp::ImageReader::take(size_t size)
+{
+    if (size > length - offset)
+        throw std::runtime_error("The compiled grammar is truncated");
+    const char *bytes = data + offset;
+    offset += size;
+    return bytes;
+}
+
+size_t Xpp::ImageReader::read_count()
+{
+    uint64_t count = read<uint64_t>();
+    if (count > length - offset)
+        throw std::runtime_error("The compiled grammar is truncated");
+    return static_cast<size_t>(count);
+}
+
+void Xpp::ImageReader::read(std::string &value)
+{
+    size_t size = read_count();
+    value.assign(take(size), size);
+}
+
+void Xpp::ImageReader::read(std::bitset<256> &bits)
+{
+    bits.reset();
+    for (size_t word = 0; word < 4; word++)
+    {
+        uint64_t value = read<uint64_t>();
+        for (size_t bit = 0; bit < 64; bit++)
+        {
+            if (value & (uint64_t(1) << bit))
+                bits.set(word * 64 + bit);
+        }
+    }
+}
+
+void Xpp::ImageReader::read(Xpp::FirstSet &set)
+{
+    read(set.bytes);
+    std::vector<uint8_t> terminals;
+    read(terminals);
+    set.terminals.assign(terminals.begin(), terminals.end());
+    read(set.tokens_only);
+    read(set.nullable);
+    read(set.end);
+}
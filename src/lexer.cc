@@ -0,0 +1,836 @@
+/**
+ * @file lexer.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "lexer.hh"
+#include "image.hh"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace
+{
+    struct FirstSet
+    {
+        std::bitset<256> bytes;
+        bool nullable;
+    };
+
+    /**
+     * Conservative analysis of an ECMAScript regular expression that computes the bytes a non-empty match can start
+     * with. Everything that is not understood widens the set to all the bytes, so the result is always a superset.
+     */
+    class RegexFirstBytes
+    {
+    private:
+        const std::string &regex;
+        size_t index = 0;
+
+        static std::bitset<256> all()
+        {
+            return std::bitset<256>().set();
+        }
+
+        static std::bitset<256> range(unsigned char from, unsigned char to)
+        {
+            std::bitset<256> set;
+            for (size_t ch = from; ch <= to; ch++)
+                set.set(ch);
+            return set;
+        }
+
+        static std::bitset<256> high_bytes()
+        {
+            return range(0x80, 0xFF);
+        }
+
+        static std::bitset<256> digits()
+        {
+            return range('0', '9');
+        }
+
+        static std::bitset<256> word()
+        {
+            return range('a', 'z') | range('A', 'Z') | range('0', '9') | range('_', '_') | high_bytes();
+        }
+
+        static std::bitset<256> spaces()
+        {
+            return range(' ', ' ') | range('\t', '\r') | high_bytes();
+        }
+
+        static std::bitset<256> single(unsigned char ch)
+        {
+            return range(ch, ch);
+        }
+
+        bool at_end()
+        {
+            return index >= regex.length();
+        }
+
+        // Bytes matched by an escape sequence, the backslash was already consumed. Zero-width escapes return false
+        bool escape(std::bitset<256> &set, bool in_class)
+        {
+            if (at_end())
+            {
+                set = all();
+                return true;
+            }
+            char ch = regex[index++];
+            switch (ch)
+            {
+            case 'd':
+                set = digits();
+                return true;
+            case 'D':
+                set = ~digits();
+                return true;
+            case 'w':
+                set = word();
+                return true;
+            case 's':
+                set = spaces();
+                return true;
+            case 'W':
+            case 'S':
+                set = all();
+                return true;
+            case 'n':
+                set = single('\n');
+                return true;
+            case 't':
+                set = single('\t');
+                return true;
+            case 'r':
+                set = single('\r');
+                return true;
+            case 'f':
+                set = single('\f');
+                return true;
+            case 'v':
+                set = single('\v');
+                return true;
+            case '0':
+                set = single('\0');
+                return true;
+            case 'b':
+                if (in_class)
+                {
+                    set = single('\b');
+                    return true;
+                }
+                return false;
+            case 'B':
+                return false;
+            default:
+                if ((ch >= '1' && ch <= '9') || ch == 'x' || ch == 'u' || ch == 'c')
+                    set = all();
+                else
+                    set = single(static_cast<unsigned char>(ch));
+                return true;
+            }
+        }
+
+        std::bitset<256> character_class()
+        {
+            std::bitset<256> set;
+            std::bitset<256> item;
+            bool negated = false;
+            unsigned char last = 0;
+            bool has_last = false;
+
+            if (!at_end() && regex[index] == '^')
+            {
+                negated = true;
+                index++;
+            }
+            while (!at_end() && regex[index] != ']')
+            {
+                char ch = regex[index++];
+                if (ch == '-' && has_last && !at_end() && regex[index] != ']')
+                {
+                    char to = regex[index++];
+                    if (to == '\\')
+                        return all();
+                    set |= range(last, static_cast<unsigned char>(to));
+                    has_last = false;
+                    continue;
+                }
+                if (ch == '\\')
+                {
+                    escape(item, true);
+                    set |= item;
+                    has_last = item.count() == 1;
+                    for (size_t byte = 0; has_last && byte < 256; byte++)
+                    {
+                        if (item.test(byte))
+                        {
+                            last = static_cast<unsigned char>(byte);
+                            break;
+                        }
+                    }
+                    continue;
+                }
+                if (ch == '[' && !at_end() && (regex[index] == ':' || regex[index] == '=' || regex[index] == '.'))
+                    return all();
+                last = static_cast<unsigned char>(ch);
+                has_last = true;
+                set.set(last);
+            }
+            index++;
+            return negated ? ~set : set;
+        }
+
+        // Parse a quantifier if any, return true if it allows zero repetitions
+        bool quantifier()
+        {
+            if (at_end())
+                return false;
+            bool zero = false;
+            switch (regex[index])
+            {
+            case '?':
+            case '*':
+                zero = true;
+                index++;
+                break;
+            case '+':
+                index++;
+                break;
+            case '{':
+                if (index + 1 >= regex.length() || !isdigit(regex[index + 1]))
+                    return false;
+                index++;
+                zero = regex[index] == '0' && (index + 1 >= regex.length() || !isdigit(regex[index + 1]));
+                while (!at_end() && regex[index] != '}')
+                    index++;
+                index++;
+                break;
+            default:
+                return false;
+            }
+            if (!at_end() && regex[index] == '?')
+                index++;
+            return zero;
+        }
+
+        FirstSet atom()
+        {
+            char ch = regex[index++];
+            std::bitset<256> set;
+            FirstSet inner;
+
+            switch (ch)
+            {
+            case '(':
+                if (!at_end() && regex[index] == '?')
+                {
+                    index++;
+                    if (!at_end() && (regex[index] == '=' || regex[index] == '!'))
+                    {
+                        index++;
+                        alternation();
+                        index++;
+                        return FirstSet{std::bitset<256>(), true};
+                    }
+                    index++;
+                }
+                inner = alternation();
+                index++;
+                return inner;
+            case '[':
+                return FirstSet{character_class(), false};
+            case '.':
+                return FirstSet{all() & ~single('\n') & ~single('\r'), false};
+            case '\\':
+                if (escape(set, false))
+                    return FirstSet{set, false};
+                return FirstSet{std::bitset<256>(), true};
+            case '^':
+            case '$':
+                return FirstSet{std::bitset<256>(), true};
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                return FirstSet{all(), false};
+            default:
+                return FirstSet{single(static_cast<unsigned char>(ch)), false};
+            }
+        }
+
+        FirstSet sequence()
+        {
+            FirstSet result{std::bitset<256>(), true};
+            FirstSet current;
+            bool zero;
+
+            while (!at_end() && regex[index] != '|' && regex[index] != ')')
+            {
+                current = atom();
+                zero = quantifier();
+                if (result.nullable)
+                {
+                    result.bytes |= current.bytes;
+                    result.nullable = current.nullable || zero;
+                }
+            }
+            return result;
+        }
+
+    public:
+        RegexFirstBytes(const std::string &regex) : regex(regex) {}
+
+        FirstSet alternation()
+        {
+            FirstSet result = sequence();
+            FirstSet current;
+            while (!at_end() && regex[index] == '|')
+            {
+                index++;
+                current = sequence();
+                result.bytes |= current.bytes;
+                result.nullable = result.nullable || current.nullable;
+            }
+            return result;
+        }
+
+        std::bitset<256> analyze()
+        {
+            FirstSet result = alternation();
+            if (!at_end())
+                return all();
+            return result.bytes;
+        }
+    };
+
+    /**
+     * Iterator over the input that records the end of the farthest byte a regular expression reads, so the bytes a
+     * match depends on are known even when it reads past the end of the match.
+     */
+    class ReadTracker
+    {
+    private:
+        const char *current = nullptr;
+        const char **farthest = nullptr;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = char;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const char *;
+        using reference = const char &;
+
+        ReadTracker() = default;
+
+        ReadTracker(const char *current, const char **farthest) : current(current), farthest(farthest) {}
+
+        reference operator*() const
+        {
+            if (current >= *farthest)
+                *farthest = current + 1;
+            return *current;
+        }
+
+        ReadTracker &operator++()
+        {
+            current++;
+            return *this;
+        }
+
+        ReadTracker operator++(int)
+        {
+            ReadTracker previous = *this;
+            current++;
+            return previous;
+        }
+
+        ReadTracker &operator--()
+        {
+            current--;
+            return *this;
+        }
+
+        ReadTracker operator--(int)
+        {
+            ReadTracker previous = *this;
+            current--;
+            return previous;
+        }
+
+        bool operator==(const ReadTracker &other) const
+        {
+            return current == other.current;
+        }
+
+        bool operator!=(const ReadTracker &other) const
+        {
+            return current != other.current;
+        }
+    };
+};
+
+Xpp::TerminalMatcher::TerminalMatcher(const Xpp::TerminalRule &rule)
+{
+    this->rule = rule;
+    this->first_bytes = RegexFirstBytes(rule.regex).analyze();
+    compile();
+}
+
+Xpp::TerminalMatcher::TerminalMatcher(const Xpp::TerminalRule &rule, const std::bitset<256> &first_bytes)
+{
+    this->rule = rule;
+    this->first_bytes = first_bytes;
+    compile();
+}
+
+void Xpp::TerminalMatcher::compile()
+{
+    static const std::pair<const char *, size_t (*)(const char *, size_t) noexcept> scanners[] = {
+        {"[-+]?\\d+", Xpp::Scanner::scan_integer},
+        {"[_a-zA-Z][_a-zA-Z0-9]*", Xpp::Scanner::scan_identifier},
+        {"[-+]?\\d+(\\.\\d+)?", Xpp::Scanner::scan_real},
+    };
+
+    for (const auto &entry : scanners)
+    {
+        if (rule.regex == entry.first)
+        {
+            this->scanner = entry.second;
+            return;
+        }
+    }
+    try
+    {
+        this->regex = std::regex(rule.regex, std::regex::ECMAScript | std::regex::optimize);
+    }
+    catch (const std::regex_error &e)
+    {
+        throw std::runtime_error("Invalid regular expression in the terminal '" + rule.name + "': " + std::string(e.what()));
+    }
+}
+
+size_t Xpp::TerminalMatcher::match(std::string_view str, size_t offset, std::cmatch &match) const
+{
+    if (scanner != nullptr)
+        return scanner(str.data() + offset, str.length() - offset);
+    auto flags = std::regex_constants::match_continuous;
+    if (offset > 0)
+        flags |= std::regex_constants::match_prev_avail;
+    if (!std::regex_search(str.data() + offset, str.data() + str.length(), match, regex, flags))
+        return 0;
+    return match.length(0);
+}
+
+size_t Xpp::TerminalMatcher::match(std::string_view str, size_t offset, size_t &read) const
+{
+    if (scanner != nullptr)
+    {
+        // A scanner reads every byte of the match and the byte that stops it
+        size_t length = scanner(str.data() + offset, str.length() - offset);
+        read = offset + length + 1;
+        return length;
+    }
+    const char *farthest = str.data() + offset;
+    std::match_results<ReadTracker> match;
+    auto flags = std::regex_constants::match_continuous;
+    if (offset > 0)
+        flags |= std::regex_constants::match_prev_avail;
+    bool found = std::regex_search(ReadTracker(str.data() + offset, &farthest), ReadTracker(str.data() + str.length(), &farthest), match, regex, flags);
+    // Reaching the end of the input is a read of the end, hence the extra byte
+    read = farthest - str.data() + 1;
+    return found ? match.length(0) : 0;
+}
+
+const Xpp::TerminalRule &Xpp::TerminalMatcher::get_rule() const noexcept
+{
+    return rule;
+}
+
+const std::bitset<256> &Xpp::TerminalMatcher::get_first_bytes() const noexcept
+{
+    return first_bytes;
+}
+
+Xpp::Lexer::Lexer(const std::vector<Xpp::TerminalRule> &terminals)
+{
+    matchers.reserve(terminals.size());
+    for (const auto &t : terminals)
+        matchers.emplace_back(t);
+    index_candidates();
+}
+
+void Xpp::Lexer::index_candidates()
+{
+    for (size_t ch = 0; ch < 256; ch++)
+    {
+        for (size_t i = 0; i < matchers.size(); i++)
+        {
+            if (matchers[i].get_first_bytes().test(ch))
+                candidates[ch].push_back(i);
+        }
+    }
+}
+
+size_t Xpp::Lexer::match(std::string_view str, size_t index, size_t &terminal, size_t &read) const
+{
+    size_t length;
+    size_t best_length = 0;
+    size_t candidate_read;
+    read = index + 1;
+    for (size_t candidate : candidates[static_cast<unsigned char>(str[index])])
+    {
+        length = matchers[candidate].match(str, index, candidate_read);
+        read = std::max(read, candidate_read);
+        if (length > best_length)
+        {
+            best_length = length;
+            terminal = candidate;
+        }
+    }
+    return best_length;
+}
+
+size_t Xpp::Lexer::match(std::string_view str, size_t index, size_t &terminal, std::cmatch &m) const
+{
+    size_t length;
+    size_t best_length = 0;
+    for (size_t candidate : candidates[static_cast<unsigned char>(str[index])])
+    {
+        length = matchers[candidate].match(str, index, m);
+        if (length > best_length)
+        {
+            best_length = length;
+            terminal = candidate;
+        }
+    }
+    return best_length;
+}
+
+void Xpp::Lexer::tokenize(std::string_view str, size_t begin, size_t end, std::vector<Xpp::Token> &tokens) const
+{
+    std::cmatch m;
+    size_t index = begin;
+    size_t length;
+    size_t terminal = 0;
+
+    while (index < end)
+    {
+        length = match(str, index, terminal, m);
+        if (length == 0)
+        {
+            index++;
+            continue;
+        }
+        tokens.push_back(Xpp::Token{static_cast<uint32_t>(terminal), static_cast<uint32_t>(length), index});
+        index += length;
+    }
+}
+
+std::vector<Xpp::Token> Xpp::Lexer::tokenize(std::string_view str) const
+{
+    std::vector<Xpp::Token> tokens;
+    tokenize(str, 0, str.length(), tokens);
+    return tokens;
+}
+
+void Xpp::Lexer::tokenize(std::string_view str, std::vector<Xpp::Token> &tokens) const
+{
+    tokens.clear();
+    tokenize(str, 0, str.length(), tokens);
+}
+
+void Xpp::Lexer::tokenize(std::string_view str, std::vector<Xpp::Token> &tokens, std::vector<size_t> &reads) const
+{
+    tokens.clear();
+    reads.assign(1, 0);
+    retokenize(str, tokens, reads, 0, 0, str.length());
+}
+
+std::pair<size_t, size_t> Xpp::Lexer::retokenize(std::string_view str, std::vector<Xpp::Token> &tokens, std::vector<size_t> &reads, size_t offset, size_t removed, size_t inserted) const
+{
+    // Every token before the first one whose steps read the edited bytes is kept as it is
+    size_t first = 0;
+    while (first < tokens.size() && reads[first] < offset)
+        first++;
+    size_t begin = first == 0 ? 0 : tokens[first - 1].index + tokens[first - 1].length;
+
+    // A previous token after the edit is tokenized the same way once the tokenizer reaches it, the byte before it
+    // must not be edited either because regular expressions can read it
+    size_t resume = first;
+    while (resume < tokens.size() && tokens[resume].index <= offset + removed)
+        resume++;
+
+    std::vector<Xpp::Token> relexed;
+    std::vector<size_t> relexed_reads;
+    size_t index = begin;
+    size_t read = 0;
+    size_t step_read;
+    size_t terminal = 0;
+    size_t length;
+    while (index < str.length())
+    {
+        while (resume < tokens.size() && tokens[resume].index - removed + inserted < index)
+            resume++;
+        if (resume < tokens.size() && tokens[resume].index - removed + inserted == index)
+            break;
+        length = match(str, index, terminal, step_read);
+        read = std::max(read, step_read);
+        if (length == 0)
+        {
+            index++;
+            continue;
+        }
+        relexed.push_back(Xpp::Token{static_cast<uint32_t>(terminal), static_cast<uint32_t>(length), index});
+        relexed_reads.push_back(read);
+        read = 0;
+        index += length;
+    }
+    if (index >= str.length())
+        resume = tokens.size();
+
+    for (size_t k = resume; k < tokens.size(); k++)
+        tokens[k].index = tokens[k].index - removed + inserted;
+    for (size_t k = resume; k < reads.size(); k++)
+        reads[k] = reads[k] - removed + inserted;
+    // The steps before the first kept token belong to its group, the last group is the one after the last token
+    reads[resume] = resume == tokens.size() ? read : std::max(reads[resume], read);
+    tokens.erase(tokens.begin() + first, tokens.begin() + resume);
+    tokens.insert(tokens.begin() + first, relexed.begin(), relexed.end());
+    reads.erase(reads.begin() + first, reads.begin() + resume);
+    reads.insert(reads.begin() + first, relexed_reads.begin(), relexed_reads.end());
+    return {begin, index};
+}
+
+std::vector<Xpp::Token> Xpp::Lexer::tokenize(std::string_view str, Xpp::ThreadPool &pool, size_t chunk_size) const
+{
+    if (chunk_size == 0)
+        chunk_size = 1;
+    if (str.length() <= chunk_size || pool.get_thread_count() == 1)
+        return tokenize(str);
+
+    std::vector<size_t> starts = {0};
+    const void *new_line;
+    size_t nominal;
+    while ((nominal = starts.back() + chunk_size) < str.length())
+    {
+        new_line = std::memchr(str.data() + nominal, '\n', std::min(chunk_size, str.length() - nominal));
+        nominal = new_line == nullptr ? nominal : static_cast<const char *>(new_line) - str.data() + 1;
+        if (nominal >= str.length())
+            break;
+        starts.push_back(nominal);
+    }
+    starts.push_back(str.length());
+
+    std::vector<std::vector<Xpp::Token>> chunks(starts.size() - 1);
+    pool.parallel_for(chunks.size(), [&](size_t k)
+                      { tokenize(str, starts[k], starts[k + 1], chunks[k]); });
+
+    std::vector<Xpp::Token> tokens;
+    size_t total = 0;
+    for (const auto &chunk : chunks)
+        total += chunk.size();
+    tokens.reserve(total);
+
+    // position is the next offset the sequential tokenizer would look at
+    size_t position = 0;
+    size_t length;
+    size_t terminal = 0;
+    std::cmatch m;
+    for (size_t k = 0; k < chunks.size(); k++)
+    {
+        const std::vector<Xpp::Token> &chunk = chunks[k];
+        auto first = chunk.begin();
+        while (position > starts[k] && position < starts[k + 1])
+        {
+            // The chunk agrees with the sequential tokenizer from the first offset that both of them look at: a
+            // token that starts there or a byte that the chunk skipped
+            first = std::lower_bound(chunk.begin(), chunk.end(), position, [](const Xpp::Token &token, size_t index)
+                                     { return token.index < index; });
+            if (first != chunk.end() && first->index == position)
+                break;
+            if (first == chunk.begin() || std::prev(first)->index + std::prev(first)->length <= position)
+                break;
+
+            length = match(str, position, terminal, m);
+            if (length == 0)
+            {
+                position++;
+                continue;
+            }
+            tokens.push_back(Xpp::Token{static_cast<uint32_t>(terminal), static_cast<uint32_t>(length), position});
+            position += length;
+        }
+        if (position >= starts[k + 1])
+            continue;
+
+        tokens.insert(tokens.end(), first, chunk.end());
+        position = starts[k + 1];
+        if (!tokens.empty())
+            position = std::max(position, tokens.back().index + tokens.back().length);
+    }
+
+    return tokens;
+}
+
+const std::vector<Xpp::TerminalMatcher> &Xpp::Lexer::get_matchers() const noexcept
+{
+    return matchers;
+}
+
+void Xpp::Lexer::save(Xpp::ImageWriter &writer) const
+{
+    writer.write<uint64_t>(matchers.size());
+    for (const auto &matcher : matchers)
+        writer.write(matcher.get_first_bytes());
+}
+
+void Xpp::Lexer::load(Xpp::ImageReader &reader, const std::vector<Xpp::TerminalRule> &terminals)
+{
+    if (reader.read_count() != terminals.size())
+        throw std::runtime_error("The compiled grammar has a wrong number of terminal matchers");
+    matchers.clear();
+    matchers.reserve(terminals.size());
+    std::bitset<256> first_bytes;
+    for (const auto &t : terminals)
+    {
+        reader.read(first_bytes);
+        matchers.emplace_back(t, first_bytes);
+    }
+    for (auto &list : candidates)
+        list.clear();
+    index_candidates();
+}
+
+size_t Xpp::ConstantTable::add(std::string_view constant)
+{
+    for (size_t i = 0; i < constants.size(); i++)
+    {
+        if (constants[i] == constant)
+            return i;
+    }
+    constants.emplace_back(constant);
+    return constants.size() - 1;
+}
+
+void Xpp::ConstantTable::build()
+{
+    std::vector<std::map<unsigned char, uint32_t>> children(1);
+    uint32_t node;
+
+    constant_nodes.clear();
+    for (const auto &constant : constants)
+    {
+        node = 0;
+        for (char ch : constant)
+        {
+            auto found = children[node].find(static_cast<unsigned char>(ch));
+            if (found == children[node].end())
+            {
+                children.emplace_back();
+                found = children[node].emplace(static_cast<unsigned char>(ch), static_cast<uint32_t>(children.size() - 1)).first;
+            }
+            node = found->second;
+        }
+        constant_nodes.push_back(node);
+    }
+
+    // The edges of a node are contiguous and sorted by byte
+    nodes.assign(children.size(), Node{0, 0});
+    edges.clear();
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        nodes[i] = Node{static_cast<uint32_t>(edges.size()), static_cast<uint32_t>(children[i].size())};
+        for (const auto &child : children[i])
+            edges.push_back(Edge{child.first, child.second});
+    }
+
+    root.fill(-1);
+    for (const auto &child : children[0])
+        root[child.first] = static_cast<int32_t>(child.second);
+}
+
+void Xpp::ConstantTable::probe(std::string_view input, size_t offset, std::vector<uint32_t> &path) const
+{
+    path.clear();
+    path.push_back(0);
+    if (nodes.empty() || offset >= input.length() || root[static_cast<unsigned char>(input[offset])] < 0)
+        return;
+
+    uint32_t node = static_cast<uint32_t>(root[static_cast<unsigned char>(input[offset++])]);
+    const Edge *edge;
+    const Edge *last;
+    while (true)
+    {
+        path.push_back(node);
+        if (offset >= input.length())
+            return;
+        edge = edges.data() + nodes[node].first_edge;
+        last = edge + nodes[node].edge_count;
+        while (edge != last && edge->byte < static_cast<unsigned char>(input[offset]))
+            edge++;
+        if (edge == last || edge->byte != static_cast<unsigned char>(input[offset]))
+            return;
+        node = edge->target;
+        offset++;
+    }
+}
+
+const std::string &Xpp::ConstantTable::get_constant(size_t id) const
+{
+    return constants.at(id);
+}
+
+size_t Xpp::ConstantTable::size() const noexcept
+{
+    return constants.size();
+}
+
+void Xpp::ConstantTable::save(Xpp::ImageWriter &writer) const
+{
+    writer.write(constants);
+    writer.write<uint64_t>(nodes.size());
+    for (const auto &node : nodes)
+    {
+        writer.write(node.first_edge);
+        writer.write(node.edge_count);
+    }
+    writer.write<uint64_t>(edges.size());
+    for (const auto &edge : edges)
+    {
+        writer.write(edge.byte);
+        writer.write(edge.target);
+    }
+    writer.write(std::vector<int32_t>(root.begin(), root.end()));
+    writer.write(constant_nodes);
+}
+
+void Xpp::ConstantTable::load(Xpp::ImageReader &reader)
+{
+    reader.read(constants);
+    nodes.resize(reader.read_count());
+    for (auto &node : nodes)
+    {
+        reader.read(node.first_edge);
+        reader.read(node.edge_count);
+    }
+    edges.resize(reader.read_count());
+    for (auto &edge : edges)
+    {
+        reader.read(edge.byte);
+        reader.read(edge.target);
+    }
+    std::vector<int32_t> root_edges;
+    reader.read(root_edges);
+    if (root_edges.size() != root.size())
+        throw std::runtime_error("The compiled grammar has a wrong constant table");
+    std::copy(root_edges.begin(), root_edges.end(), root.begin());
+    reader.read(constant_nodes);
+}
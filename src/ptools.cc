@@ -9,9 +9,62 @@
  */
 
 #include "ptools.hh"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 char ParserTools::get_next(std::string str, size_t &index) noexcept
 {
     if (index >= str.length()) return 0;
     return str[index++];
-}
\ No newline at end of file
+}
+
+ParserTools::LineIndex::LineIndex(std::string_view str)
+{
+    assign(str);
+}
+
+void ParserTools::LineIndex::assign(std::string_view str)
+{
+    const char *data = str.data();
+    size_t i = 0;
+    length = str.length();
+    line_starts.resize(1);
+    line_starts.reserve(length / 32 + 1);
+
+#ifdef __SSE2__
+    const __m128i new_line = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16)
+    {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), new_line));
+        while (mask != 0)
+        {
+            line_starts.push_back(i + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    const char *found;
+    while (i < length && (found = static_cast<const char *>(std::memchr(data + i, '\n', length - i))) != nullptr)
+    {
+        i = found - data + 1;
+        line_starts.push_back(i);
+    }
+}
+
+std::pair<size_t, size_t> ParserTools::LineIndex::get_column_line(size_t index) const noexcept
+{
+    if (index > length)
+        index = length;
+    size_t line = std::upper_bound(line_starts.begin(), line_starts.end(), index) - line_starts.begin() - 1;
+    return std::pair<size_t, size_t>(index - line_starts[line], line);
+}
+
+size_t ParserTools::LineIndex::get_line_count() const noexcept
+{
+    return line_starts.size();
+}
@@ -9,6 +9,8 @@
  */
 
 #include "rel.hh"
+#include "image.hh"
+#include <algorithm>
 
 bool Xpp::RuleExpression::is_boundary_set() noexcept
 {
@@ -30,11 +32,47 @@ bool Xpp::RuleExpression::is_strict_case_insensitive_set() noexcept
     return this->case_insensitive_flag == CASE_INSENSITIVE_STRICT;
 }
 
+Xpp::FirstSet &Xpp::RuleExpression::get_first_set() noexcept
+{
+    return this->first_set;
+}
+
+const Xpp::FirstSet &Xpp::RuleExpression::get_first_set() const noexcept
+{
+    return this->first_set;
+}
+
+void Xpp::FirstSet::merge(const Xpp::FirstSet &other)
+{
+    nullable = nullable || other.nullable;
+    end = end || other.end;
+    if (other.bytes.none())
+        return;
+    if (bytes.none())
+    {
+        tokens_only = other.tokens_only;
+        terminals = other.terminals;
+    }
+    else
+    {
+        tokens_only = tokens_only && other.tokens_only;
+        terminals.resize(std::max(terminals.size(), other.terminals.size()));
+        for (size_t i = 0; i < other.terminals.size(); i++)
+            terminals[i] = terminals[i] || other.terminals[i];
+    }
+    bytes |= other.bytes;
+}
+
 std::vector<Xpp::ExpressionElement> &Xpp::RuleExpression::get_elements() noexcept
 {
     return this->elements;
 }
 
+const std::vector<Xpp::ExpressionElement> &Xpp::RuleExpression::get_elements() const noexcept
+{
+    return this->elements;
+}
+
 std::vector<Xpp::ExpressionElement>::iterator Xpp::RuleExpression::begin()
 {
     return this->elements.begin();
@@ -45,243 +83,140 @@ std::vector<Xpp::ExpressionElement>::iterator Xpp::RuleExpression::end()
     return this->elements.end();
 }
 
-Xpp::ExpressionElement &Xpp::RuleExpression::operator[](size_t index) noexcept
+std::vector<Xpp::ExpressionElement>::const_iterator Xpp::RuleExpression::begin() const
 {
-    return this->elements[index];
+    return this->elements.cbegin();
 }
 
-Xpp::RuleExpression::RuleExpression(const std::string &rule_expression)
+std::vector<Xpp::ExpressionElement>::const_iterator Xpp::RuleExpression::end() const
 {
-    if (rule_expression.starts_with('['))
-    {
-        index++;
-        parse_flags(rule_expression);
-    }
-    while (index < rule_expression.length())
-        parse_expression(rule_expression);
-}
-
-void Xpp::RuleExpression::parse_flags(std::string exp)
-{
-    char next = ParserTools::get_next(exp, index);
-    while (next != ']')
-    {
-        switch (next)
-        {
-        case '\0':
-            throw std::runtime_error("Unexpected the end of the expression, ']' was expected");
-        case 'i':
-            if (case_insensitive_flag == CASE_INSENSITIVE_STRICT)
-                throw std::runtime_error("Cannot set 'i' flag after 'I' was already set");
-            if (case_insensitive_flag == CASE_INSENSITIVE_SOFT)
-                throw std::runtime_error("'i' flag is already set");
-            case_insensitive_flag = CASE_INSENSITIVE_SOFT;
-            break;
-        case 'I':
-            if (case_insensitive_flag == CASE_INSENSITIVE_SOFT)
-                throw std::runtime_error("Cannot set 'I' flag after 'i' was already set");
-            if (case_insensitive_flag == CASE_INSENSITIVE_STRICT)
-                throw std::runtime_error("'I' flag is already set");
-            case_insensitive_flag = CASE_INSENSITIVE_STRICT;
-            break;
-        case 'b':
-            if (boundary_flag)
-                throw std::runtime_error("'b' flag is already set");
-            boundary_flag = true;
-            break;
-        case 's':
-            if (ignore_spaces)
-                throw std::runtime_error("'s' flag is already set");
-            ignore_spaces = true;
-            break;
-        case '<':
-            throw std::runtime_error("Unrecognized '<' token. Did you forget ']'?");
-        default:
-            throw std::runtime_error("Unrecognized '" + std::string(1, next) + "' flag");
-        }
-        next = ParserTools::get_next(exp, index);
-    }
+    return this->elements.cend();
 }
 
-void Xpp::RuleExpression::parse_expression(std::string exp)
+Xpp::ExpressionElement &Xpp::RuleExpression::operator[](size_t index) noexcept
 {
-    if (exp[index] == '[')
-        throw std::runtime_error("Unexpected '[' token. Did you mean '\\['?");
-    if (exp[index] == '<')
-    {
-        index++;
-        parse_reference(exp);
-        return;
-    }
-    parse_constant_term(exp);
+    return this->elements[index];
 }
 
-void Xpp::RuleExpression::parse_reference(std::string exp)
+Xpp::RuleExpression::RuleExpression(const std::string &rule_expression)
 {
-    char next = ParserTools::get_next(exp, index);
-    std::vector<std::string> reference_names = {""};
-    size_t current_name = 0;
-    bool is_alternative = false;
-    std::vector<Quantifier> quantifiers = {Quantifier{NONE, 0, 0}};
-
-    while (true)
+    // The same reader checks the expressions of compile-time grammars, here it builds the elements
+    struct Builder
     {
-        if (next == '\0')
-            throw std::runtime_error("Unexpected the end of the expression. Did you forget '>'?");
+        RuleExpression &expression;
 
-        if (next == '|')
+        void flags(const Rel::Flags &flags)
         {
-            reference_names.push_back("");
-            quantifiers.push_back(Quantifier{NONE, 0, 0});
-            current_name++;
-            is_alternative = true;
-            continue;
+            expression.case_insensitive_flag = flags.case_insensitive;
+            expression.boundary_flag = flags.boundary;
+            expression.ignore_spaces = flags.ignore_spaces;
         }
 
-        if (next == '?' || next == '*' || next == '+' || next == '{')
+        void constant(std::string_view raw)
         {
-            quantifiers[current_name] = parse_quantifier(exp, is_alternative, next);
-            if (quantifiers[current_name].type != EXACT_VALUE)
-            {
-                elements.push_back(ExpressionElement{RULE_REFERENCE, "", {ExpressionReference{reference_names[current_name], quantifiers[current_name]}}});
-                return;
-            }
+            std::string value(raw.length(), '\0');
+            value.resize(Rel::unescape(raw, value.data()));
+            ExpressionElement element;
+            element.type = CONSTANT_TERMINAL;
+            element.value = std::move(value);
+            expression.elements.push_back(std::move(element));
         }
 
-        if (next == '>')
-            break;
-
-        if (!isalnum(next))
-            throw std::runtime_error("Unexpected '" + std::string(1, next) + "' token");
-
-        reference_names[current_name] += next;
-        next = ParserTools::get_next(exp, index);
-    }
-
-    if (is_alternative)
-    {
-        std::vector<ExpressionReference> references;
-        if (reference_names[current_name] == "")
-            throw std::runtime_error("Unexpected the end of the reference after '|'");
-
-        for (size_t i = 0; i < reference_names.size(); i++)
+        void reference(const Rel::Reference *references, size_t count, bool alternative)
         {
-            references.push_back(ExpressionReference{reference_names[i], quantifiers[i]});
+            ExpressionElement element;
+            element.type = alternative ? ALTERNATIVE : RULE_REFERENCE;
+            for (size_t i = 0; i < count; i++)
+            {
+                ExpressionReference reference;
+                reference.reference_to = std::string(references[i].name);
+                reference.quantifier = references[i].quantifier;
+                element.references.push_back(std::move(reference));
+            }
+            expression.elements.push_back(std::move(element));
         }
-        elements.push_back(ExpressionElement{ALTERNATIVE, "", references});
-        return;
-    }
-    elements.push_back(ExpressionElement{RULE_REFERENCE, "", {ExpressionReference{reference_names[0], quantifiers[0]}}});
+    };
+
+    Builder builder{*this};
+    Rel::read(rule_expression, builder);
+    index = rule_expression.length();
+
+    // The spaces are skipped and the boundaries are checked between the elements, the boundary also after the
+    // last one
+    int edge = (ignore_spaces ? EDGE_SKIP_SPACES : EDGE_NONE) | (boundary_flag ? EDGE_BOUNDARY : EDGE_NONE);
+    for (size_t i = 1; i < elements.size(); i++)
+        elements[i].edge = edge;
+    if (boundary_flag && !elements.empty())
+        end_edge = EDGE_BOUNDARY;
 }
 
-Xpp::Quantifier Xpp::RuleExpression::parse_quantifier(std::string exp, bool is_alternative, char type)
+size_t Xpp::RuleExpression::get_last_index() noexcept
 {
-    if (is_alternative && type != '{')
-        throw std::runtime_error("Cannot use ?, *, + and range quantifier with an alternative references");
-    char ch;
-    if ((ch = ParserTools::get_next(exp, index)) != '>' && type != '{')
-        throw std::runtime_error("Unexpected '" + std::string(1, ch) + "' token, '>' was expected");
-    if (type == '?')
-        return Quantifier{ZERO_OR_ONE, 0, 0};
-    if (type == '*')
-        return Quantifier{ZERO_OR_MORE, 0, 0};
-    if (type == '+')
-        return Quantifier{ONE_OR_MORE, 0, 0};
-
-    std::vector<std::string> values = {"", ""};
-    size_t current_value = 0;
+    return index;
+}
 
-    while (ch != '}')
+void Xpp::RuleExpression::save(Xpp::ImageWriter &writer) const
+{
+    writer.write<uint64_t>(elements.size());
+    for (const auto &el : elements)
     {
-        if (ch == ':')
+        writer.write(el.type);
+        writer.write(el.value);
+        writer.write(el.constant_id);
+        writer.write(el.case_insensitive);
+        writer.write(el.folded_value);
+        writer.write(el.edge);
+        writer.write<uint64_t>(el.references.size());
+        for (const auto &ref : el.references)
         {
-            if (current_value != 0)
-                throw std::runtime_error("Unexpected ':' token");
-            current_value = 1;
+            writer.write(ref.reference_to);
+            writer.write(ref.quantifier.type);
+            writer.write(ref.quantifier.x_value);
+            writer.write(ref.quantifier.y_value);
+            writer.write(ref.kind);
+            writer.write(ref.id);
+            writer.write(ref.symbol);
+            writer.write(ref.first_set);
         }
-
-        if (!isdigit(ch))
-            throw std::runtime_error("Unexpected token '" + std::string(1, ch) + "' in {} quantifier");
-
-        values[current_value] += ch;
-        ch = ParserTools::get_next(exp, index);
     }
-
-    if (current_value == 1)
-    {
-        if (is_alternative)
-            throw std::runtime_error("Cannot use range quantifier with alternative references");
-        if (values[0] == "")
-            throw std::runtime_error("Expected value before ':' in '{:" + values[1] + "}'");
-        if (values[current_value] == "")
-            throw std::runtime_error("Expected value after ':' in '{" + values[0] + ":}'");
-        return Quantifier{EXACT_RANGE, std::stoull(values[0]), std::stoull(values[1])};
-    }
-    if (values[0] == "")
-        throw std::runtime_error("Expected a value after '{'");
-    return Quantifier{EXACT_VALUE, std::stoull(values[0]), 0};
+    writer.write(case_insensitive_flag);
+    writer.write(boundary_flag);
+    writer.write(ignore_spaces);
+    writer.write(end_edge);
+    writer.write(index);
+    writer.write(rule_name);
+    writer.write(first_set);
 }
 
-void Xpp::RuleExpression::parse_constant_term(std::string exp)
+void Xpp::RuleExpression::load(Xpp::ImageReader &reader)
 {
-    std::string value;
-    char ch;
-    bool escape = false;
-
-    while (true)
+    elements.resize(reader.read_count());
+    for (auto &el : elements)
     {
-        ch = ParserTools::get_next(exp, index);
-        if (ch == '\0')
-            break;
-        if (escape)
-        {
-            escape = false;
-            switch (ch)
-            {
-            case 't':
-                value += '\t';
-                break;
-            case 'b':
-                throw std::runtime_error("Cannot match \\b character");
-            case 'n':
-                value += '\n';
-                break;
-            case 'r':
-                value += '\r';
-                break;
-            case 'v':
-                value += '\v';
-                break;
-            case '0':
-                value += '\0';
-                break;
-            default:
-                value += ch;
-                break;
-            }
-            continue;
-        }
-
-        if (ch == '\\')
+        reader.read(el.type);
+        reader.read(el.value);
+        reader.read(el.constant_id);
+        reader.read(el.case_insensitive);
+        reader.read(el.folded_value);
+        reader.read(el.edge);
+        el.references.resize(reader.read_count());
+        for (auto &ref : el.references)
         {
-            escape = true;
-            continue;
+            reader.read(ref.reference_to);
+            reader.read(ref.quantifier.type);
+            reader.read(ref.quantifier.x_value);
+            reader.read(ref.quantifier.y_value);
+            reader.read(ref.kind);
+            reader.read(ref.id);
+            reader.read(ref.symbol);
+            reader.read(ref.first_set);
         }
-
-        if (ch == '<')
-        {
-            --index;
-            break;
-        }
-        if (ch == '>')
-            throw std::runtime_error("Unexpected '>' token");
-        value += ch;
     }
-
-    elements.push_back(ExpressionElement{CONSTANT_TERMINAL, value, {}});
+    reader.read(case_insensitive_flag);
+    reader.read(boundary_flag);
+    reader.read(ignore_spaces);
+    reader.read(end_edge);
+    reader.read(index);
+    reader.read(rule_name);
+    reader.read(first_set);
 }
-
-size_t Xpp::RuleExpression::get_last_index() noexcept
-{
-    return index;
-}
\ No newline at end of file
@@ -0,0 +1,358 @@
+/**
+ * @file scanner.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "scanner.hh"
+#include <array>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define XPP_X86_SCANNERS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // A class is the union of at most 3 byte ranges, a folded range also matches the upper case letters
+    struct Range
+    {
+        unsigned char low;
+        unsigned char high;
+        bool fold;
+    };
+
+    struct ClassDefinition
+    {
+        Range ranges[3];
+        size_t count;
+        bool negate;
+    };
+
+    const ClassDefinition definitions[] = {
+        {{{'a', 'z', true}, {'0', '9', false}}, 2, false},                  // CLASS_ALNUM
+        {{{'0', '9', false}}, 1, false},                                    // CLASS_DIGIT
+        {{{'a', 'z', true}}, 1, false},                                     // CLASS_ALPHA
+        {{{'\t', '\t', false}, {'\v', '\f', false}, {' ', ' ', false}}, 3, false}, // CLASS_SPACE
+        {{{'0', '9', false}, {'a', 'f', true}}, 2, false},                  // CLASS_HEX_DIGIT
+        {{{'0', '7', false}}, 1, false},                                    // CLASS_OCT_DIGIT
+        {{{'\n', '\n', false}, {'\r', '\r', false}}, 2, true},              // CLASS_ANY
+        {{{'a', 'z', true}, {'0', '9', false}, {'_', '_', false}}, 3, false}, // CLASS_IDENTIFIER
+    };
+
+    constexpr size_t class_count = sizeof(definitions) / sizeof(definitions[0]);
+
+    using ClassTable = std::array<std::array<bool, 256>, class_count>;
+
+    ClassTable build_tables()
+    {
+        ClassTable tables{};
+        for (size_t c = 0; c < class_count; c++)
+        {
+            for (size_t byte = 0; byte < 256; byte++)
+            {
+                bool found = false;
+                for (size_t r = 0; r < definitions[c].count; r++)
+                {
+                    const Range &range = definitions[c].ranges[r];
+                    size_t value = range.fold ? (byte | 0x20) : byte;
+                    found = found || (value >= range.low && value <= range.high);
+                }
+                tables[c][byte] = found != definitions[c].negate;
+            }
+        }
+        return tables;
+    }
+
+    const ClassTable tables = build_tables();
+
+    size_t scan_scalar(Xpp::CharacterClass cls, const char *data, size_t length) noexcept
+    {
+        const std::array<bool, 256> &table = tables[cls];
+        size_t i = 0;
+        while (i < length && table[static_cast<unsigned char>(data[i])])
+            i++;
+        return i;
+    }
+
+    // Folded letters of the tail are accumulated with the ones of the vector loop, so the strict check is done once
+    bool equals_folded_scalar(const char *data, const char *folded, size_t length, bool &upper, bool &lower) noexcept
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            unsigned char ch = static_cast<unsigned char>(data[i]);
+            bool is_upper = static_cast<unsigned char>(ch - 'A') <= 'Z' - 'A';
+            upper = upper || is_upper;
+            lower = lower || static_cast<unsigned char>(ch - 'a') <= 'z' - 'a';
+            if ((is_upper ? ch | 0x20 : ch) != static_cast<unsigned char>(folded[i]))
+                return false;
+        }
+        return true;
+    }
+
+#ifdef XPP_X86_SCANNERS
+    // x is in [low, high] if min(x - low, high - low) == x - low as unsigned bytes
+    __attribute__((target("sse2"))) size_t scan_sse2(Xpp::CharacterClass cls, const char *data, size_t length) noexcept
+    {
+        const ClassDefinition &definition = definitions[cls];
+        __m128i lows[3];
+        __m128i widths[3];
+        const __m128i case_bit = _mm_set1_epi8(0x20);
+        const __m128i negate = definition.negate ? _mm_set1_epi8(-1) : _mm_setzero_si128();
+        size_t i = 0;
+
+        for (size_t r = 0; r < definition.count; r++)
+        {
+            lows[r] = _mm_set1_epi8(static_cast<char>(definition.ranges[r].low));
+            widths[r] = _mm_set1_epi8(static_cast<char>(definition.ranges[r].high - definition.ranges[r].low));
+        }
+
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i folded = _mm_or_si128(bytes, case_bit);
+            __m128i in_class = _mm_setzero_si128();
+            for (size_t r = 0; r < definition.count; r++)
+            {
+                __m128i offset = _mm_sub_epi8(definition.ranges[r].fold ? folded : bytes, lows[r]);
+                in_class = _mm_or_si128(in_class, _mm_cmpeq_epi8(_mm_min_epu8(offset, widths[r]), offset));
+            }
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_xor_si128(in_class, negate)));
+            if (mask != 0xFFFF)
+                return i + __builtin_ctz(~mask);
+        }
+        return i + scan_scalar(cls, data + i, length - i);
+    }
+
+    __attribute__((target("avx2"))) size_t scan_avx2(Xpp::CharacterClass cls, const char *data, size_t length) noexcept
+    {
+        const ClassDefinition &definition = definitions[cls];
+        __m256i lows[3];
+        __m256i widths[3];
+        const __m256i case_bit = _mm256_set1_epi8(0x20);
+        const __m256i negate = definition.negate ? _mm256_set1_epi8(-1) : _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (size_t r = 0; r < definition.count; r++)
+        {
+            lows[r] = _mm256_set1_epi8(static_cast<char>(definition.ranges[r].low));
+            widths[r] = _mm256_set1_epi8(static_cast<char>(definition.ranges[r].high - definition.ranges[r].low));
+        }
+
+        for (; i + 32 <= length; i += 32)
+        {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i folded = _mm256_or_si256(bytes, case_bit);
+            __m256i in_class = _mm256_setzero_si256();
+            for (size_t r = 0; r < definition.count; r++)
+            {
+                __m256i offset = _mm256_sub_epi8(definition.ranges[r].fold ? folded : bytes, lows[r]);
+                in_class = _mm256_or_si256(in_class, _mm256_cmpeq_epi8(_mm256_min_epu8(offset, widths[r]), offset));
+            }
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_xor_si256(in_class, negate)));
+            if (mask != 0xFFFFFFFFu)
+                return i + __builtin_ctz(~mask);
+        }
+        return i + scan_sse2(cls, data + i, length - i);
+    }
+
+    __attribute__((target("sse2"))) bool equals_folded_sse2(const char *data, const char *folded, size_t length, bool &upper, bool &lower) noexcept
+    {
+        const __m128i upper_low = _mm_set1_epi8('A');
+        const __m128i lower_low = _mm_set1_epi8('a');
+        const __m128i width = _mm_set1_epi8('Z' - 'A');
+        const __m128i case_bit = _mm_set1_epi8(0x20);
+        __m128i any_upper = _mm_setzero_si128();
+        __m128i any_lower = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i upper_offset = _mm_sub_epi8(bytes, upper_low);
+            __m128i lower_offset = _mm_sub_epi8(bytes, lower_low);
+            __m128i is_upper = _mm_cmpeq_epi8(_mm_min_epu8(upper_offset, width), upper_offset);
+            __m128i lowered = _mm_or_si128(bytes, _mm_and_si128(is_upper, case_bit));
+            __m128i expected = _mm_loadu_si128(reinterpret_cast<const __m128i *>(folded + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(lowered, expected)) != 0xFFFF)
+                return false;
+            any_upper = _mm_or_si128(any_upper, is_upper);
+            any_lower = _mm_or_si128(any_lower, _mm_cmpeq_epi8(_mm_min_epu8(lower_offset, width), lower_offset));
+        }
+        upper = upper || _mm_movemask_epi8(any_upper) != 0;
+        lower = lower || _mm_movemask_epi8(any_lower) != 0;
+        return equals_folded_scalar(data + i, folded + i, length - i, upper, lower);
+    }
+
+    __attribute__((target("avx2"))) bool equals_folded_avx2(const char *data, const char *folded, size_t length, bool &upper, bool &lower) noexcept
+    {
+        const __m256i upper_low = _mm256_set1_epi8('A');
+        const __m256i lower_low = _mm256_set1_epi8('a');
+        const __m256i width = _mm256_set1_epi8('Z' - 'A');
+        const __m256i case_bit = _mm256_set1_epi8(0x20);
+        __m256i any_upper = _mm256_setzero_si256();
+        __m256i any_lower = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (; i + 32 <= length; i += 32)
+        {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i upper_offset = _mm256_sub_epi8(bytes, upper_low);
+            __m256i lower_offset = _mm256_sub_epi8(bytes, lower_low);
+            __m256i is_upper = _mm256_cmpeq_epi8(_mm256_min_epu8(upper_offset, width), upper_offset);
+            __m256i lowered = _mm256_or_si256(bytes, _mm256_and_si256(is_upper, case_bit));
+            __m256i expected = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(folded + i));
+            if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lowered, expected))) != 0xFFFFFFFFu)
+                return false;
+            any_upper = _mm256_or_si256(any_upper, is_upper);
+            any_lower = _mm256_or_si256(any_lower, _mm256_cmpeq_epi8(_mm256_min_epu8(lower_offset, width), lower_offset));
+        }
+        upper = upper || _mm256_movemask_epi8(any_upper) != 0;
+        lower = lower || _mm256_movemask_epi8(any_lower) != 0;
+        return equals_folded_sse2(data + i, folded + i, length - i, upper, lower);
+    }
+#endif
+
+    Xpp::ScannerLevel detect_level() noexcept
+    {
+#ifdef XPP_X86_SCANNERS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return Xpp::SCANNER_AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return Xpp::SCANNER_SSE2;
+#endif
+        return Xpp::SCANNER_SCALAR;
+    }
+
+    const Xpp::ScannerLevel level = detect_level();
+};
+
+bool Xpp::Scanner::is_in_class(Xpp::CharacterClass cls, char ch) noexcept
+{
+    return tables[cls][static_cast<unsigned char>(ch)];
+}
+
+size_t Xpp::Scanner::scan(Xpp::CharacterClass cls, const char *data, size_t length) noexcept
+{
+    return scan(cls, data, length, level);
+}
+
+size_t Xpp::Scanner::scan(Xpp::CharacterClass cls, const char *data, size_t length, Xpp::ScannerLevel scanner_level) noexcept
+{
+    // Short runs are the common case, the vector loop only pays off once the first bytes are in the class
+    if (length == 0 || !tables[cls][static_cast<unsigned char>(data[0])])
+        return 0;
+    switch (scanner_level)
+    {
+#ifdef XPP_X86_SCANNERS
+    case SCANNER_AVX2:
+        return scan_avx2(cls, data, length);
+    case SCANNER_SSE2:
+        return scan_sse2(cls, data, length);
+#endif
+    default:
+        return scan_scalar(cls, data, length);
+    }
+}
+
+Xpp::ScannerLevel Xpp::Scanner::get_level() noexcept
+{
+    return level;
+}
+
+bool Xpp::Scanner::is_supported(Xpp::ScannerLevel scanner_level) noexcept
+{
+    return scanner_level <= level;
+}
+
+bool Xpp::Scanner::get_class(const std::string &name, Xpp::CharacterClass &cls) noexcept
+{
+    static const std::pair<const char *, Xpp::CharacterClass> names[] = {
+        {"alnum", CLASS_ALNUM},
+        {"digit", CLASS_DIGIT},
+        {"alpha", CLASS_ALPHA},
+        {"space", CLASS_SPACE},
+        {"hexDigit", CLASS_HEX_DIGIT},
+        {"octDigit", CLASS_OCT_DIGIT},
+        {"any", CLASS_ANY},
+    };
+    for (const auto &entry : names)
+    {
+        if (name == entry.first)
+        {
+            cls = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Xpp::Scanner::scan_new_line(const char *data, size_t length) noexcept
+{
+    if (length >= 1 && data[0] == '\n')
+        return 1;
+    if (length >= 2 && data[0] == '\r' && data[1] == '\n')
+        return 2;
+    return 0;
+}
+
+size_t Xpp::Scanner::scan_integer(const char *data, size_t length) noexcept
+{
+    size_t sign = length > 0 && (data[0] == '-' || data[0] == '+') ? 1 : 0;
+    size_t digits = scan(CLASS_DIGIT, data + sign, length - sign);
+    return digits == 0 ? 0 : sign + digits;
+}
+
+size_t Xpp::Scanner::scan_identifier(const char *data, size_t length) noexcept
+{
+    if (length == 0 || (data[0] != '_' && !is_in_class(CLASS_ALPHA, data[0])))
+        return 0;
+    return 1 + scan(CLASS_IDENTIFIER, data + 1, length - 1);
+}
+
+size_t Xpp::Scanner::scan_real(const char *data, size_t length) noexcept
+{
+    size_t integer = scan_integer(data, length);
+    if (integer == 0 || integer + 1 >= length || data[integer] != '.')
+        return integer;
+    size_t fraction = scan(CLASS_DIGIT, data + integer + 1, length - integer - 1);
+    return fraction == 0 ? integer : integer + 1 + fraction;
+}
+
+bool Xpp::Scanner::equals_folded(const char *data, const char *folded, size_t length, bool strict) noexcept
+{
+    bool upper = false;
+    bool lower = false;
+    bool equal;
+    switch (level)
+    {
+#ifdef XPP_X86_SCANNERS
+    case SCANNER_AVX2:
+        equal = equals_folded_avx2(data, folded, length, upper, lower);
+        break;
+    case SCANNER_SSE2:
+        equal = equals_folded_sse2(data, folded, length, upper, lower);
+        break;
+#endif
+    default:
+        equal = equals_folded_scalar(data, folded, length, upper, lower);
+        break;
+    }
+    return equal && !(strict && upper && lower);
+}
+
+std::string Xpp::Scanner::fold(std::string_view str)
+{
+    std::string folded(str);
+    for (char &ch : folded)
+    {
+        if (static_cast<unsigned char>(ch - 'A') <= 'Z' - 'A')
+            ch |= 0x20;
+    }
+    return folded;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file source.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "source.hh"
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XPP_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+Xpp::Source::~Source()
+{
+#ifdef XPP_HAS_MMAP
+    if (mapping != nullptr)
+        munmap(mapping, mapping_length);
+#endif
+}
+
+std::shared_ptr<const Xpp::Source> Xpp::Source::from_string(std::string str)
+{
+    std::shared_ptr<Xpp::Source> source(new Xpp::Source());
+    source->content = std::move(str);
+    source->data = source->content.data();
+    source->length = source->content.length();
+    return source;
+}
+
+std::shared_ptr<const Xpp::Source> Xpp::Source::map_file(const std::string &path)
+{
+#ifdef XPP_HAS_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open the file: " + path);
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Cannot read the size of the file: " + path);
+    }
+
+    std::shared_ptr<Xpp::Source> source(new Xpp::Source());
+    // An empty file cannot be mapped, it is just an empty source
+    if (info.st_size > 0)
+    {
+        void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Cannot map the file: " + path);
+        }
+#ifdef MADV_SEQUENTIAL
+        madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+#endif
+        source->mapping = mapping;
+        source->mapping_length = static_cast<size_t>(info.st_size);
+        source->data = static_cast<const char *>(mapping);
+        source->length = source->mapping_length;
+    }
+    close(fd);
+    return source;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (file.fail())
+        throw std::runtime_error("Cannot open the file: " + path);
+    std::stringstream buff;
+    buff << file.rdbuf();
+    return from_string(buff.str());
+#endif
+}
@@ -0,0 +1,202 @@
+/**
+ * @file thread_pool.cc
+ * @author Simone Ancona
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "thread_pool.hh"
+
+Xpp::ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    // The calling thread takes part in parallel_for, so it counts as one of the threads
+    for (size_t i = 1; i < threads; i++)
+        workers.emplace_back(&Xpp::ThreadPool::work, this);
+}
+
+Xpp::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void Xpp::ThreadPool::work()
+{
+    std::function<void()> task;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this]
+                           { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+size_t Xpp::ThreadPool::get_thread_count() const noexcept
+{
+    return workers.size() + 1;
+}
+
+void Xpp::ThreadPool::parallel_for(size_t count, const std::function<void(size_t)> &function)
+{
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> running = 0;
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+    size_t helpers = std::min(workers.size(), count > 0 ? count - 1 : 0);
+
+    auto run = [&]
+    {
+        size_t i;
+        while ((i = next.fetch_add(1)) < count)
+        {
+            try
+            {
+                function(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    running = helpers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < helpers; i++)
+        {
+            tasks.emplace_back([&]
+                               {
+                                   run();
+                                   std::lock_guard<std::mutex> lock(done_mutex);
+                                   if (--running == 0)
+                                       done.notify_one(); });
+        }
+    }
+    available.notify_all();
+
+    run();
+    {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [&]
+                  { return running == 0; });
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void Xpp::ThreadPool::parallel_for_stealing(size_t count, const std::function<void(size_t, size_t)> &function)
+{
+    struct Range
+    {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    size_t threads = std::min(workers.size() + 1, std::max<size_t>(count, 1));
+    std::vector<Range> ranges(threads);
+    std::atomic<size_t> running = threads - 1;
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+    for (size_t t = 0; t < threads; t++)
+    {
+        ranges[t].begin = count * t / threads;
+        ranges[t].end = count * (t + 1) / threads;
+    }
+
+    // Take the next index of the own range or steal, false when every range is empty
+    auto next = [&](size_t thread, size_t &index)
+    {
+        {
+            std::lock_guard<std::mutex> lock(ranges[thread].mutex);
+            if (ranges[thread].begin < ranges[thread].end)
+            {
+                index = ranges[thread].begin++;
+                return true;
+            }
+        }
+        for (size_t k = 1; k < threads; k++)
+        {
+            Range &victim = ranges[(thread + k) % threads];
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.begin == victim.end)
+                    continue;
+                begin = victim.begin + (victim.end - victim.begin) / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            std::lock_guard<std::mutex> lock(ranges[thread].mutex);
+            ranges[thread].begin = begin + 1;
+            ranges[thread].end = end;
+            index = begin;
+            return true;
+        }
+        return false;
+    };
+
+    auto run = [&](size_t thread)
+    {
+        size_t i;
+        while (next(thread, i))
+        {
+            try
+            {
+                function(thread, i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t t = 1; t < threads; t++)
+        {
+            tasks.emplace_back([&, t]
+                               {
+                                   run(t);
+                                   std::lock_guard<std::mutex> lock(done_mutex);
+                                   if (--running == 0)
+                                       done.notify_one(); });
+        }
+    }
+    available.notify_all();
+
+    run(0);
+    {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [&]
+                  { return running == 0; });
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
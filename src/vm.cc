@@ -0,0 +1,296 @@
+/**
+ * @file vm.cc
+ * @author Simone Ancona
+ * @brief Parsing engine that runs the bytecode of the grammar
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "xparser.hh"
+
+namespace
+{
+    // A rule being matched, the registers of the alternatives and of the quantifiers belong to it
+    struct Call
+    {
+        const Xpp::Rule *rule = nullptr;
+        Xpp::AST node;
+        Xpp::Index start;
+        // Where the caller continues when the rule matches and when it fails
+        uint32_t resume = 0;
+        uint32_t fail = 0;
+        // The end of the input read by the caller when the rule was called
+        size_t outer_read = 0;
+        bool tried = false;
+        Xpp::Index alternative_start;
+        Xpp::Index loop_start;
+        Xpp::Index loop_index;
+        size_t loop_children = 0;
+        size_t count = 0;
+    };
+};
+
+bool Xpp::Parser::analyze_rule_bytecode(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens)
+{
+    const Xpp::Bytecode &program = grammar->get_bytecode();
+    const Xpp::Instruction *code = program.get_code().data();
+    const Xpp::Rule *rules = grammar->get_rules().data();
+    // The calls above depth are kept to be reused, so a call does not allocate once the stack is deep enough
+    std::vector<Call> calls(1);
+    size_t depth = 1;
+    Call *call = &calls[0];
+    call->rule = rules;
+    call->node = std::move(ast);
+    call->start = parse_index;
+    uint32_t pc = program.get_entry(0);
+
+    while (true)
+    {
+        const Xpp::Instruction &instruction = code[pc];
+        switch (instruction.op)
+        {
+        case OP_PREDICT:
+            if (!is_viable(program.get_first_set(instruction.a), tokens))
+            {
+                prediction_statistics.expressions_pruned++;
+                pc = instruction.fail;
+                break;
+            }
+            prediction_statistics.expressions_tried++;
+            call->tried = true;
+            begin_expression(*call->rule);
+            pc++;
+            break;
+
+        case OP_RETURN:
+        {
+            end_expression(*call->rule, call->start.char_index, true);
+            if (depth == 1)
+            {
+                ast = std::move(call->node);
+                return true;
+            }
+            Call &done = *call;
+            call = &calls[--depth - 1];
+            rule_matched(call->node, done.rule - rules, done.start, done.outer_read, std::move(done.node));
+            pc = done.resume;
+            break;
+        }
+
+        case OP_BACKTRACK:
+            end_expression(*call->rule, call->start.char_index, false);
+            backtrack(call->node, call->start, 0);
+            pc++;
+            break;
+
+        case OP_NO_EXPRESSION:
+        {
+            if (failures.empty() || !call->tried)
+                push_failure(FAILURE_NO_EXPRESSION, *call->rule);
+            if (depth == 1)
+            {
+                ast = std::move(call->node);
+                return false;
+            }
+            pc = call->fail;
+            rule_failed(call->rule - rules, call->start, call->outer_read);
+            call = &calls[--depth - 1];
+            break;
+        }
+
+        case OP_STRING:
+            pc = match_constant(call->node, tokens, *call->rule, instruction.c, std::string_view(program.get_text(instruction.a), instruction.b)) ? pc + 1 : instruction.fail;
+            break;
+
+        case OP_FOLDED:
+        case OP_FOLDED_STRICT:
+            pc = match_folded_constant(call->node, tokens, *call->rule, instruction.c, std::string_view(program.get_text(instruction.a), instruction.b), instruction.op == OP_FOLDED_STRICT)
+                     ? pc + 1
+                     : instruction.fail;
+            break;
+
+        case OP_CLASS:
+        case OP_NEW_LINE:
+        case OP_EOF:
+        {
+            const Xpp::Repetitions &repetitions = program.get_repetitions(instruction.b);
+            Xpp::ReferenceKind kind = instruction.op == OP_CLASS ? REFERENCE_CLASS : instruction.op == OP_NEW_LINE ? REFERENCE_NEW_LINE : REFERENCE_EOF;
+            pc = match_implicit_terminal(call->node, tokens, *call->rule, kind, instruction.a, repetitions.min, repetitions.max, instruction.c) ? pc + 1 : instruction.fail;
+            break;
+        }
+
+        case OP_TOKEN:
+        {
+            if (!spend_step())
+            {
+                pc = instruction.fail;
+                break;
+            }
+            const Xpp::Token *token = parse_index.token_index < tokens.size() ? &tokens[parse_index.token_index] : nullptr;
+            if (token != nullptr && token->index == parse_index.char_index && token->terminal == instruction.a)
+            {
+                emit_terminal(call->node, *call->rule, token->index, token->length);
+                mark_read(token->index + token->length);
+                parse_index = {parse_index.token_index + 1, token->index + token->length};
+                pc++;
+                break;
+            }
+            mark_read(parse_index.char_index + 1);
+            push_failure(FAILURE_REFERENCE, *call->rule, instruction.c);
+            pc = instruction.fail;
+            break;
+        }
+
+        case OP_CALL:
+        {
+            if (!spend_step())
+            {
+                pc = instruction.fail;
+                break;
+            }
+            if (reuse_rule(call->node, tokens, instruction.a))
+            {
+                pc++;
+                break;
+            }
+            bool matched;
+            if (replay_rule(call->node, instruction.a, matched))
+            {
+                pc = matched ? pc + 1 : instruction.fail;
+                break;
+            }
+            if (depth == calls.size())
+                calls.emplace_back();
+            call = &calls[depth++];
+            call->rule = rules + instruction.a;
+            call->start = parse_index;
+            call->resume = pc + 1;
+            call->fail = instruction.fail;
+            call->outer_read = read_end;
+            call->tried = false;
+            // Events do not need the node, the one left by the last call is empty
+            if (events == nullptr)
+                call->node = Xpp::AST(call->rule->name, std::vector<Xpp::AST>{});
+            call->node.set_span(parse_index.char_index, 0, 0);
+            read_end = parse_index.char_index;
+            pc = program.get_entry(instruction.a);
+            break;
+        }
+
+        case OP_CHOICE:
+            call->alternative_start = parse_index;
+            pc++;
+            break;
+
+        case OP_ALTERNATIVE:
+            parse_index = call->alternative_start;
+            if (!is_viable(program.get_first_set(instruction.a), tokens))
+            {
+                prediction_statistics.alternatives_pruned++;
+                pc = instruction.fail;
+                break;
+            }
+            prediction_statistics.alternatives_tried++;
+            pc++;
+            break;
+
+        case OP_NO_ALTERNATIVE:
+            parse_index = call->alternative_start;
+            push_failure(FAILURE_ALTERNATIVE, *call->rule);
+            pc = instruction.fail;
+            break;
+
+        case OP_JUMP:
+            pc = instruction.a;
+            break;
+
+        case OP_MARK:
+        case OP_MARK_EXACT:
+            call->loop_start = call->loop_index = parse_index;
+            call->loop_children = call->node.get_children().size();
+            call->count = 0;
+            // A failed exact quantifier undoes the repetitions that matched
+            if (instruction.op == OP_MARK_EXACT && events != nullptr)
+                events->begin();
+            pc++;
+            break;
+
+        case OP_RESTORE:
+            parse_index = call->loop_index;
+            pc++;
+            break;
+
+        case OP_AGAIN_COUNT:
+            call->count++;
+            [[fallthrough]];
+        case OP_AGAIN:
+            // A repetition that matched nothing would repeat forever
+            if (parse_index.char_index != call->loop_index.char_index)
+            {
+                call->loop_index = parse_index;
+                pc = instruction.a;
+                break;
+            }
+            pc++;
+            break;
+
+        case OP_AT_LEAST_ONE:
+            parse_index = call->loop_index;
+            if (call->count != 0)
+            {
+                pc++;
+                break;
+            }
+            push_failure(FAILURE_ONE_OR_MORE, *call->rule, instruction.c);
+            pc = instruction.fail;
+            break;
+
+        case OP_REPEAT:
+            if (++call->count < instruction.b)
+            {
+                pc = instruction.a;
+                break;
+            }
+            if (events != nullptr)
+                events->commit();
+            pc = instruction.c;
+            break;
+
+        case OP_REPEAT_FAILED:
+            if (events != nullptr)
+                events->rollback();
+            backtrack(call->node, call->loop_start, call->loop_children);
+            push_failure(FAILURE_EXACT_VALUE, *call->rule, instruction.c, instruction.b);
+            pc = instruction.fail;
+            break;
+
+        case OP_RANGE:
+            call->loop_index = parse_index;
+            pc = ++call->count < instruction.b ? instruction.a : pc + 1;
+            break;
+
+        case OP_RANGE_END:
+            parse_index = call->loop_index;
+            if (call->count >= instruction.b)
+            {
+                if (events != nullptr)
+                    events->commit();
+                pc++;
+                break;
+            }
+            if (events != nullptr)
+                events->rollback();
+            backtrack(call->node, call->loop_start, call->loop_children);
+            push_failure(FAILURE_EXACT_RANGE, *call->rule, instruction.c, instruction.b);
+            pc = instruction.fail;
+            break;
+
+        case OP_EDGE:
+            pc = match_edge(tokens, *call->rule, instruction.a, call->start.char_index) ? pc + 1 : instruction.fail;
+            break;
+        }
+    }
+}
@@ -10,347 +10,908 @@
 
 #include "xparser.hh"
 
+Xpp::SyntaxError Xpp::format_failure(Xpp::FailureKind kind, const std::string &rule_name, std::string_view text, size_t count, size_t offset, const ParserTools::LineIndex &lines)
+{
+    std::pair<size_t, size_t> column_line = lines.get_column_line(offset);
+    SyntaxErrorType type = UNMATCHED_RULE;
+    std::string message;
+    switch (kind)
+    {
+    case FAILURE_CONSTANT:
+        type = EXPECTED_TOKEN;
+        message = "'" + std::string(1, text[count]) + "' was expected";
+        break;
+    case FAILURE_FOLDED_CONSTANT:
+        type = EXPECTED_TOKEN;
+        message = "'" + std::string(text) + "' was expected";
+        break;
+    case FAILURE_REFERENCE:
+        type = EXPECTED_TOKEN;
+        message = "'" + std::string(text) + "' was expected";
+        break;
+    case FAILURE_ONE_OR_MORE:
+        message = "'" + std::string(text) + "' was expected at least once. Use 'get_error_stack' to get the error stack.";
+        break;
+    case FAILURE_EXACT_VALUE:
+        message = "'" + std::string(text) + "' was expected " + std::to_string(count) + " times";
+        break;
+    case FAILURE_EXACT_RANGE:
+        message = "'" + std::string(text) + "' was expected at least " + std::to_string(count) + " times";
+        break;
+    case FAILURE_ALTERNATIVE:
+        message = "No match found on the alternative in the rule '" + rule_name + "'. Use 'get_error_stack' to get the error stack.";
+        break;
+    case FAILURE_RULE:
+        message = "Cannot match '" + rule_name + "' rule. Use 'get_error_stack' to get the error stack.";
+        break;
+    case FAILURE_NO_EXPRESSION:
+        message = "Cannot match '" + rule_name + "' rule";
+        break;
+    case FAILURE_BOUNDARY:
+        type = EXPECTED_TOKEN;
+        message = "A space was expected";
+        break;
+    }
+    return {type, message, offset, column_line.first, column_line.second};
+}
+
+Xpp::ImplicitMatch Xpp::scan_implicit_terminal(Xpp::ReferenceKind kind, size_t id, size_t min, size_t max, std::string_view input) noexcept
+{
+    size_t length = 0;
+    size_t count = 0;
+    size_t read = 0;
+    switch (kind)
+    {
+    case REFERENCE_CLASS:
+        // Every character of the class is one byte, so the whole run is found with a single vectorized scan
+        length = count = Xpp::Scanner::scan(static_cast<Xpp::CharacterClass>(id), input.data(), std::min(max, input.length()));
+        read = length + 1;
+        break;
+    case REFERENCE_NEW_LINE:
+    {
+        size_t new_line;
+        while (count < max && (new_line = Xpp::Scanner::scan_new_line(input.data() + length, input.length() - length)) != 0)
+        {
+            length += new_line;
+            count++;
+        }
+        read = length + 2;
+        break;
+    }
+    case REFERENCE_EOF:
+        count = input.empty() ? std::max<size_t>(min, 1) : 0;
+        read = 1;
+        break;
+    default:
+        break;
+    }
+    return {count, length, read};
+}
+
 Xpp::Parser::Parser(const Jpp::Json &grammar)
 {
-    this->grammar = grammar;
-    this->generate_from_json();
+    this->grammar = std::make_shared<const Xpp::CompiledGrammar>(grammar);
 }
 
 Xpp::Parser::Parser(const std::string &grammar)
 {
-    this->grammar.parse(grammar);
-    this->generate_from_json();
+    this->grammar = std::make_shared<const Xpp::CompiledGrammar>(grammar);
 }
 
 Xpp::Parser::Parser(const std::ifstream &file)
 {
-    this->grammar.parse(this->get_string_from_file(file));
-    this->generate_from_json();
+    this->grammar = std::make_shared<const Xpp::CompiledGrammar>(file);
+}
+
+Xpp::Parser::Parser(std::shared_ptr<const Xpp::CompiledGrammar> grammar)
+{
+    this->grammar = std::move(grammar);
+}
+
+std::shared_ptr<const Xpp::CompiledGrammar> Xpp::Parser::get_grammar() const noexcept
+{
+    return grammar;
+}
+
+void Xpp::Parser::save_compiled(const std::string &path) const
+{
+    grammar->save(path);
+}
+
+void Xpp::Parser::load_compiled(const std::string &path)
+{
+    grammar = Xpp::CompiledGrammar::load(path);
+    // The cached results and the parsers of the batches belong to the previous grammar
+    packrat_cache.clear();
+    batch_parsers.clear();
 }
 
 Xpp::AST Xpp::Parser::generate_ast(const std::string &input_string)
 {
-    return parse(tokenize(input_string));
+    std::shared_ptr<const Xpp::Source> owned = Xpp::Source::from_string(input_string);
+    return generate_ast(owned, owned->get_view());
 }
 
-std::stack<Xpp::SyntaxError> &Xpp::Parser::get_error_stack() noexcept
+Xpp::AST Xpp::Parser::generate_ast(std::string_view input_string)
 {
-    return error_stack;
+    return generate_ast(nullptr, input_string);
 }
 
-Xpp::SyntaxError Xpp::Parser::get_last_error()
+Xpp::AST Xpp::Parser::generate_ast(const char *input_string)
 {
-    return error_stack.top();
+    return generate_ast(std::string_view(input_string));
 }
 
-std::string Xpp::Parser::get_string_from_file(const std::ifstream &file)
+Xpp::AST Xpp::Parser::generate_ast_from_file(const std::string &path)
 {
-    std::stringstream buff;
-    buff << file.rdbuf();
-    return buff.str();
+    std::shared_ptr<const Xpp::Source> mapped = Xpp::Source::map_file(path);
+    return generate_ast(mapped, mapped->get_view());
 }
 
-void Xpp::Parser::generate_from_json()
+Xpp::AST Xpp::Parser::generate_ast(std::shared_ptr<const Xpp::Source> input_source, std::string_view input_string)
 {
-    auto children = grammar.get_children();
-    auto terminals = children.find("terminals");
-    if (terminals == children.end())
-        throw std::runtime_error("The 'terminals' property is required in the JSON grammar.");
-    auto rules = children.find("rules");
-    if (rules == children.end())
-        throw std::runtime_error("The 'rules' property is required in the JSON grammar.");
+    Xpp::ParseResult result = try_generate_ast(std::move(input_source), input_string);
+    if (!result.success)
+        throw Xpp::SyntaxErrorException("An error occurred while parsing the string:\n\t" + result.error.message + "\nUse 'get_error_stack' or 'get_last_error' for more.");
+    return std::move(result.ast);
+}
 
-    if (!terminals->second.is_array())
-        throw std::runtime_error("The 'terminals' property must be an array");
-    if (!rules->second.is_array())
-        throw std::runtime_error("The 'rules' property must be an array");
+Xpp::ParseResult Xpp::Parser::try_generate_ast(std::shared_ptr<const Xpp::Source> input_source, std::string_view input_string)
+{
+    this->source = std::move(input_source);
+    this->input = input_string;
+    start_budget();
+    return parse(tokenize_input());
+}
 
-    auto terminalsArray = terminals->second.get_children();
-    auto rulesArray = rules->second.get_children();
+Xpp::ParseResult Xpp::Parser::parse_events(std::string_view input_string, Xpp::EventHandler &handler)
+{
+    events = &handler;
+    Xpp::ParseResult result = try_generate_ast(nullptr, input_string);
+    events = nullptr;
+    return result;
+}
 
-    generate_terminal_rules(terminalsArray);
-    generate_rules(rulesArray);
+Xpp::ParseResult Xpp::Parser::parse_events_from_file(const std::string &path, Xpp::EventHandler &handler)
+{
+    std::shared_ptr<const Xpp::Source> mapped = Xpp::Source::map_file(path);
+    events = &handler;
+    Xpp::ParseResult result = try_generate_ast(mapped, mapped->get_view());
+    events = nullptr;
+    return result;
 }
 
-void Xpp::Parser::generate_terminal_rules(const std::map<std::string, Jpp::Json> &terminalsArray)
+Xpp::ParseResult Xpp::Parser::reparse(Xpp::AST previous, const std::vector<Xpp::TextEdit> &edits)
 {
-    for (auto terminal : terminalsArray)
+    start_budget();
+    std::string edited(input);
+    // The range of the edited input that differs from the previous one, everything after it is only shifted
+    size_t begin = input.length();
+    size_t end = input.length();
+    for (size_t i = 0; i < edits.size(); i++)
     {
-        try
-        {
-            this->terminals.push_back(Xpp::TerminalRule{std::any_cast<std::string>(terminal.second["name"].get_value()), std::any_cast<std::string>(terminal.second["regex"].get_value())});
-        }
-        catch (const std::runtime_error e)
-        {
-            throw std::runtime_error("Error while parsing the array of terminals, go to https://github.com/SimoneAncona/xparser#define-a-grammar for more");
-        }
+        const Xpp::TextEdit &edit = edits[i];
+        if (edit.offset > edited.length() || edit.removed > edited.length() - edit.offset)
+            throw std::runtime_error("The edit is outside of the input");
+        size_t edit_end = edit.offset + edit.inserted.length();
+        if (i == 0 || end <= edit.offset)
+            end = i == 0 ? edit_end : std::max(end, edit_end);
+        else
+            end = std::max(end > edit.offset + edit.removed ? end - edit.removed + edit.inserted.length() : edit_end, edit_end);
+        begin = i == 0 ? edit.offset : std::min(begin, edit.offset);
+        edited.replace(edit.offset, edit.removed, edit.inserted);
     }
+    size_t previous_end = end + input.length() - edited.length();
+
+    // Without the reads of the previous tokens nothing is known about what an edit changes, and the values of the
+    // previous AST can only be reused if the AST keeps its input alive and was built from it
+    bool reuse = incremental && source != nullptr && token_reads.size() == token_buffer.size() + 1 && is_last_tree(previous);
+    std::shared_ptr<const Xpp::Source> edited_source = Xpp::Source::from_string(std::move(edited));
+    if (!reuse)
+        return try_generate_ast(edited_source, edited_source->get_view());
+
+    std::pair<size_t, size_t> relexed = grammar->get_lexer().retokenize(edited_source->get_view(), token_buffer, token_reads, begin, previous_end - begin, end - begin);
+    damage_begin = std::min(begin, relexed.first);
+    damage_new_end = std::max(end, relexed.second);
+    damage_end = damage_new_end + previous_end - end;
+    this->source = edited_source;
+    this->input = source->get_view();
+    lines.assign(input);
+
+    previous_tree = std::move(previous);
+    reusing = true;
+    Xpp::ParseResult result = parse(token_buffer);
+    reusing = false;
+    previous_tree = Xpp::AST();
+    // The failures inside the reused nodes are unknown, the error of an input that does not match comes from a
+    // complete parse
+    if (!result.success)
+        result = parse(token_buffer);
+    return result;
 }
 
-void Xpp::Parser::generate_rules(const std::map<std::string, Jpp::Json> &rulesArray)
+std::vector<Xpp::ParseResult> Xpp::Parser::parse_batch(std::span<const std::string_view> inputs)
 {
-    std::set<std::pair<std::string, std::string>> referenced_rule_names;
-    std::string rule_name;
-    for (auto ruleJSON : rulesArray)
+    if (batch_pool == nullptr)
+        batch_pool = std::make_shared<Xpp::ThreadPool>(batch_options.threads);
+    while (batch_parsers.size() < batch_pool->get_thread_count())
+        batch_parsers.emplace_back(grammar);
+    for (auto &worker : batch_parsers)
     {
-        try
-        {
-            rule_name = std::any_cast<std::string>(ruleJSON.second["name"].get_value());
-            this->rules.push_back(Xpp::Rule{rule_name, parse_expressions(ruleJSON.second["expressions"].get_children(), referenced_rule_names, rule_name)});
-        }
-        catch (const std::runtime_error e)
-        {
-            throw std::runtime_error("Error while parsing the array of rules, go to https://github.com/SimoneAncona/xparser#define-a-grammar for more:\n\t" + std::string(e.what()));
-        }
+        if (worker.packrat_options.enabled != packrat_options.enabled || worker.packrat_options.max_entries != packrat_options.max_entries)
+            worker.set_packrat_options(packrat_options);
+        worker.prediction = prediction;
+        worker.engine = engine;
+        worker.budget = budget;
     }
 
-    for (auto rule : referenced_rule_names)
-    {
-        if (find_rule(rule.first) == nullptr && find_terminal_rule(rule.first) == nullptr && std::find(implicit_terminals.begin(), implicit_terminals.end(), rule.first) == std::end(implicit_terminals))
-            throw std::runtime_error("Undefined reference to the rule '" + rule.first + "' in the rule '" + rule.second + "'");
-    }
+    std::vector<Xpp::ParseResult> results(inputs.size());
+    batch_pool->parallel_for_stealing(inputs.size(), [&](size_t thread, size_t i)
+                                      { results[i] = batch_parsers[thread].try_generate_ast(nullptr, inputs[i]); });
+    return results;
+}
 
-    if (rules.size() == 0)
-        throw std::runtime_error("No rules were specified. You must specify at least one rule");
+Xpp::ParseResult Xpp::Parser::try_generate_ast(const std::string &input_string)
+{
+    std::shared_ptr<const Xpp::Source> owned = Xpp::Source::from_string(input_string);
+    return try_generate_ast(owned, owned->get_view());
 }
 
-std::vector<Xpp::RuleExpression> Xpp::Parser::parse_expressions(const std::map<std::string, Jpp::Json> &expressions, std::set<std::pair<std::string, std::string>> &referenced_rules, const std::string &rule_name)
+Xpp::ParseResult Xpp::Parser::try_generate_ast(std::string_view input_string)
 {
-    std::vector<Xpp::RuleExpression> parsed_expressions;
-    Xpp::RuleExpression temp_expression;
+    return try_generate_ast(nullptr, input_string);
+}
 
-    for (auto exp : expressions)
-    {
-        temp_expression = Xpp::RuleExpression(any_cast<std::string>(exp.second.get_value()));
-        get_reference_names(temp_expression, referenced_rules, rule_name);
-        parsed_expressions.push_back(temp_expression);
-    }
+Xpp::ParseResult Xpp::Parser::try_generate_ast(const char *input_string)
+{
+    return try_generate_ast(std::string_view(input_string));
+}
 
-    return parsed_expressions;
+Xpp::AST Xpp::Parser::make_terminal(const std::string &rule_name, size_t index, size_t length)
+{
+    Xpp::AST node(rule_name, input.substr(index, length), source);
+    node.set_span(index, length, length);
+    return node;
 }
 
-void Xpp::Parser::get_reference_names(Xpp::RuleExpression &exp, std::set<std::pair<std::string, std::string>> &references, const std::string &rule_name)
+void Xpp::Parser::emit_terminal(Xpp::AST &ast, const Xpp::Rule &rule, size_t index, size_t length)
 {
-    for (auto el : exp.get_elements())
-    {
-        if (el.type == ExpressionElementType::RULE_REFERENCE)
-            references.insert(std::pair<std::string, std::string>(el.references[0].reference_to, rule_name));
-    }
+    if (events != nullptr)
+        events->terminal(rule, input.substr(index, length));
+    else
+        attach(ast, make_terminal(rule.name, index, length));
 }
 
-Xpp::Rule *Xpp::Parser::find_rule(const std::string &name)
+void Xpp::Parser::begin_expression(const Xpp::Rule &rule)
 {
-    for (auto &rule : rules)
-    {
-        if (rule.name == name)
-            return &rule;
-    }
-    return nullptr;
+    if (events == nullptr)
+        return;
+    events->begin();
+    events->enter_rule(rule, parse_index.char_index);
 }
 
-Xpp::TerminalRule *Xpp::Parser::find_terminal_rule(const std::string &name)
+void Xpp::Parser::end_expression(const Xpp::Rule &rule, size_t start, bool matched)
 {
-    for (auto &t : terminals)
+    if (events == nullptr)
+        return;
+    if (!matched)
     {
-        if (t.name == name)
-            return &t;
+        events->rollback();
+        return;
     }
-    return nullptr;
+    events->commit();
+    events->exit_rule(rule, input.substr(start, parse_index.char_index - start));
 }
 
-std::vector<Xpp::Token> Xpp::Parser::tokenize(const std::string &str)
+void Xpp::Parser::attach(Xpp::AST &ast, Xpp::AST child)
 {
-    std::vector<Xpp::Token> tokens;
-    std::vector<Xpp::Token> temp;
+    if (budget.max_nodes != 0 && ++nodes > budget.max_nodes)
+        exceed_budget(NODE_LIMIT_EXCEEDED);
+    // Nodes keep the offset in the input until they are attached, then the offset from their parent
+    child.set_span(child.get_start() - ast.get_start(), child.get_length(), child.get_lookahead());
+    ast.push_child(std::move(child));
+}
 
-    for (auto t : terminals)
+void Xpp::Parser::mark_read(size_t end) noexcept
+{
+    if (end > read_end)
+        read_end = end;
+}
+
+bool Xpp::Parser::is_last_tree(Xpp::AST &tree)
+{
+    if (parsed_source == nullptr || parsed_source != source || tree.get_start() != 0 || tree.get_length() != parsed_length || tree.get_lookahead() != parsed_lookahead)
+        return false;
+    // An AST of another input can have the same span, but its values are views of that input
+    Xpp::AST *node = &tree;
+    while (!node->is_terminal() && !node->get_children().empty())
+        node = &(*node)[0];
+    if (!node->is_terminal())
+        return true;
+    std::string_view value = node->get_value_view();
+    return value.data() >= input.data() && value.data() + value.length() <= input.data() + input.length();
+}
+
+Xpp::AST *Xpp::Parser::find_previous(size_t rule_id, size_t offset)
+{
+    const std::string &name = grammar->get_rules()[rule_id].name;
+    Xpp::AST *node = &previous_tree;
+    size_t node_start = previous_tree.get_start();
+    while (true)
     {
-        temp = get_tokens(str, t);
-        for (auto tm : temp)
-        {
-            tokens.push_back(tm);
-        }
+        std::vector<Xpp::AST> &children = node->get_children();
+        auto child = std::upper_bound(children.begin(), children.end(), offset - node_start, [](size_t value, const Xpp::AST &element)
+                                      { return value < element.get_start(); });
+        if (child == children.begin())
+            return nullptr;
+        --child;
+        size_t child_start = node_start + child->get_start();
+        if (child_start == offset && !child->is_terminal() && child->get_rule_name() == name)
+            return &*child;
+        if (child->is_terminal() || (child_start != offset && offset >= child_start + child->get_length()))
+            return nullptr;
+        node = &*child;
+        node_start = child_start;
     }
+}
 
-    std::sort(tokens.begin(), tokens.end(), Xpp::token_compare);
+bool Xpp::Parser::reuse_rule(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, size_t rule_id)
+{
+    if (!reusing)
+        return false;
+    size_t start = parse_index.char_index;
+    size_t previous_start;
+    if (start < damage_begin)
+        previous_start = start;
+    else if (start >= damage_new_end)
+        previous_start = start - damage_new_end + damage_end;
+    else
+        return false;
+    Xpp::AST *node = find_previous(rule_id, previous_start);
+    // A node can only be reused if none of the bytes it read changed
+    if (node == nullptr || (previous_start < damage_begin && previous_start + node->get_lookahead() > damage_begin))
+        return false;
 
-    return tokens;
+    Xpp::AST reused = std::move(*node);
+    size_t length = reused.get_length();
+    size_t lookahead = reused.get_lookahead();
+    // The span stays in the previous tree so it can still be searched, the empty rule name marks the node as moved
+    *node = Xpp::AST();
+    node->set_span(reused.get_start(), length, lookahead);
+    reused.set_span(start, length, lookahead);
+    attach(ast, std::move(reused));
+    mark_read(start + lookahead);
+    parse_index.char_index = start + length;
+    parse_index.token_index = std::partition_point(tokens.begin() + parse_index.token_index, tokens.end(), [&](const Xpp::Token &token)
+                                                   { return token.index < parse_index.char_index; }) - tokens.begin();
+    return true;
 }
 
-bool Xpp::token_compare(Xpp::Token t1, Xpp::Token t2)
+const Xpp::TerminalRule &Xpp::Parser::get_terminal_rule(const Xpp::Token &token) const
 {
-    return t1.index < t2.index;
+    return grammar->get_terminals().at(token.terminal);
 }
 
-std::vector<Xpp::Token> Xpp::Parser::get_tokens(const std::string &str, Xpp::TerminalRule rule)
+std::pair<size_t, size_t> Xpp::Parser::get_column_line(size_t index) const noexcept
 {
-    std::vector<Xpp::Token> tokens;
-    std::smatch m;
-    std::pair<size_t, size_t> column_line;
-    std::string::const_iterator s_begin = str.cbegin();
-    size_t index = 0;
+    return lines.get_column_line(index);
+}
 
-    while (std::regex_search(s_begin, str.cend(), m, std::regex(rule.regex)))
+std::stack<Xpp::SyntaxError> &Xpp::Parser::get_error_stack()
+{
+    if (!error_stack_built)
     {
-        index = (str.length() - m.suffix().length()) - m.str().length();
-        column_line = Xpp::Parser::get_column_line(str, index);
-        tokens.push_back(Xpp::Token{rule, index, column_line.first, column_line.second, m.str()});
-        s_begin = m.suffix().first;
+        error_stack = {};
+        for (const auto &failure : failures)
+            error_stack.push(describe_failure(failure));
+        error_stack_built = true;
     }
+    return error_stack;
+}
 
-    return tokens;
+Xpp::SyntaxError Xpp::Parser::get_last_error()
+{
+    if (!error_stack_built && !failures.empty())
+        return describe_failure(failures.back());
+    if (error_stack.empty())
+        throw std::runtime_error("There are no errors");
+    return error_stack.top();
 }
 
-std::pair<size_t, size_t> Xpp::Parser::get_column_line(std::string_view str, long long index)
+std::vector<Xpp::Token> Xpp::Parser::tokenize(std::string_view str)
 {
-    size_t column = 0;
-    size_t line = 0;
-    long long i = 0;
-    for (auto ch : str)
-    {
-        if (i == index)
-            return std::pair<size_t, size_t>(column, line);
-        if (ch == '\n')
-        {
-            line++;
-            column = 0;
-        }
-        i++;
-        column++;
-    }
-    return std::pair<size_t, size_t>(0, 0);
+    lines.assign(str);
+    if (pool != nullptr)
+        return grammar->get_lexer().tokenize(str, *pool, tokenizer_options.chunk_size);
+    return grammar->get_lexer().tokenize(str);
+}
+
+const std::vector<Xpp::Token> &Xpp::Parser::tokenize_input()
+{
+    lines.assign(input);
+    token_reads.clear();
+    if (incremental)
+        grammar->get_lexer().tokenize(input, token_buffer, token_reads);
+    else if (pool != nullptr)
+        token_buffer = grammar->get_lexer().tokenize(input, *pool, tokenizer_options.chunk_size);
+    else
+        grammar->get_lexer().tokenize(input, token_buffer);
+    return token_buffer;
+}
+
+void Xpp::Parser::set_tokenizer_options(const Xpp::TokenizerOptions &options)
+{
+    tokenizer_options = options;
+    pool = nullptr;
+    if (options.threads != 1)
+        pool = std::make_shared<Xpp::ThreadPool>(options.threads);
+}
+
+void Xpp::Parser::set_incremental(bool enabled) noexcept
+{
+    incremental = enabled;
+}
+
+void Xpp::Parser::set_budget(const Xpp::ParseBudget &parse_budget)
+{
+    budget = parse_budget;
+}
+
+void Xpp::Parser::set_engine(Xpp::ParserEngine parser_engine) noexcept
+{
+    engine = parser_engine;
+}
+
+void Xpp::Parser::set_prediction(bool enabled) noexcept
+{
+    prediction = enabled;
+}
+
+const Xpp::PredictionStatistics &Xpp::Parser::get_prediction_statistics() const noexcept
+{
+    return prediction_statistics;
+}
+
+bool Xpp::Parser::is_viable(const Xpp::FirstSet &set, const std::vector<Xpp::Token> &tokens) noexcept
+{
+    size_t char_index = parse_index.char_index;
+    if (!prediction || set.nullable)
+        return true;
+    mark_read(char_index + 1);
+    if (char_index >= input.length())
+        return set.end;
+    if (!set.bytes[static_cast<unsigned char>(input[char_index])])
+        return false;
+    if (!set.tokens_only)
+        return true;
+    const Xpp::Token *token = parse_index.token_index < tokens.size() ? &tokens[parse_index.token_index] : nullptr;
+    if (token == nullptr || token->index != char_index)
+        return false;
+    mark_read(token->index + token->length);
+    return token->terminal < set.terminals.size() && set.terminals[token->terminal];
+}
+
+void Xpp::Parser::set_packrat_options(const Xpp::PackratOptions &options)
+{
+    packrat_options = options;
+    packrat_cache.clear();
+    packrat_cache.set_capacity(options.max_entries);
+}
+
+void Xpp::Parser::set_batch_options(const Xpp::BatchOptions &options)
+{
+    batch_options = options;
+    batch_pool = nullptr;
+    batch_parsers.clear();
 }
 
-Xpp::AST Xpp::Parser::parse(const std::vector<Xpp::Token> &tokens)
+Xpp::ParseResult Xpp::Parser::parse(const std::vector<Xpp::Token> &tokens)
 {
-    Xpp::AST ast(rules[0].name, std::vector<Xpp::AST>{});
+    Xpp::AST ast = events != nullptr ? Xpp::AST() : Xpp::AST(grammar->get_rules()[0].name, std::vector<Xpp::AST>{});
     this->parse_index = {0, 0};
-    try
+    this->failures.clear();
+    this->error_stack = {};
+    this->error_stack_built = true;
+    this->probe_index = SIZE_MAX;
+    this->packrat_cache.clear();
+    this->prediction_statistics = {};
+    this->read_end = 0;
+    this->parsed_source = nullptr;
+    bool matched;
+    switch (engine)
+    {
+    case ENGINE_ITERATIVE:
+        matched = analyze_rule_iterative(ast, tokens);
+        break;
+    case ENGINE_BYTECODE:
+        matched = analyze_rule_bytecode(ast, tokens);
+        break;
+    default:
+        matched = analyze_rule(ast, tokens, grammar->get_rules()[0]);
+        break;
+    }
+    // The cached nodes share their children with the AST, so the caller gets an AST that is not shared
+    packrat_cache.clear();
+    if (budget_exceeded)
     {
-        analyze_rule(ast, tokens, rules[0]);
+        // The syntax errors found before the parse was stopped say nothing about the input
+        failures.clear();
+        error_stack = {};
+        error_stack.push(describe_budget());
+        return {false, Xpp::AST(), error_stack.top()};
     }
-    catch (Xpp::SyntaxErrorException &e)
+    if (!matched)
+        return {false, Xpp::AST(), get_error_stack().top()};
+    ast.set_span(0, parse_index.char_index, read_end);
+    if (events == nullptr)
     {
-        throw Xpp::SyntaxErrorException("An error occurred while parsing the string:\n\t" + std::string(e.what()) + "\nUse 'get_error_stack' or 'get_last_error' for more.");
+        parsed_source = source;
+        parsed_length = parse_index.char_index;
+        parsed_lookahead = read_end;
     }
+    return {true, std::move(ast), {}};
+}
 
-    return ast;
+void Xpp::Parser::start_budget()
+{
+    steps = 0;
+    nodes = 0;
+    budget_exceeded = false;
+    if (budget.time_limit.count() != 0)
+        deadline = std::chrono::steady_clock::now() + budget.time_limit;
+    // The first step checks every limit and finds the next step that needs a check
+    bool limited = budget.max_steps != 0 || budget.time_limit.count() != 0 || budget.cancellation != nullptr;
+    next_check = limited ? 0 : SIZE_MAX;
 }
 
-void Xpp::Parser::analyze_rule(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Rule &rule)
+bool Xpp::Parser::check_budget() noexcept
 {
-    bool error = true;
-    for (auto rule_exp : rule.expressions)
+    if (budget_exceeded)
+        return false;
+    if (budget.max_steps != 0 && steps > budget.max_steps)
+        return exceed_budget(STEP_LIMIT_EXCEEDED);
+    if (budget.cancellation != nullptr && budget.cancellation->is_cancelled())
+        return exceed_budget(PARSE_CANCELLED);
+    if (budget.time_limit.count() != 0 && std::chrono::steady_clock::now() >= deadline)
+        return exceed_budget(TIME_LIMIT_EXCEEDED);
+    next_check = SIZE_MAX;
+    if (budget.time_limit.count() != 0 || budget.cancellation != nullptr)
+        next_check = steps + std::max<size_t>(budget.check_interval, 1);
+    if (budget.max_steps != 0)
+        next_check = std::min(next_check, budget.max_steps + 1);
+    return true;
+}
+
+bool Xpp::Parser::exceed_budget(Xpp::SyntaxErrorType type) noexcept
+{
+    // Every following step fails, so the engine gives up without trying the remaining alternatives
+    budget_exceeded = true;
+    budget_error = type;
+    budget_offset = parse_index.char_index;
+    next_check = 0;
+    return false;
+}
+
+Xpp::SyntaxError Xpp::Parser::describe_budget() const
+{
+    std::pair<size_t, size_t> column_line = lines.get_column_line(budget_offset);
+    std::string message;
+    switch (budget_error)
     {
-        if (!analyze_expression(ast, tokens, rule_exp, rule.name) && error)
-            error = false;
+    case STEP_LIMIT_EXCEEDED:
+        message = "The parse exceeded the limit of " + std::to_string(budget.max_steps) + " steps";
+        break;
+    case TIME_LIMIT_EXCEEDED:
+        message = "The parse exceeded its time limit";
+        break;
+    case NODE_LIMIT_EXCEEDED:
+        message = "The parse exceeded the limit of " + std::to_string(budget.max_nodes) + " nodes";
+        break;
+    default:
+        message = "The parse was cancelled";
+        break;
     }
-    if (error)
-        throw Xpp::SyntaxErrorException(get_last_error().message);
+    return {budget_error, message, budget_offset, column_line.first, column_line.second};
+}
+
+void Xpp::Parser::record_failure(const Xpp::Failure &failure)
+{
+    last_failure = failure;
+    if (!failures.empty() && (failure.offset < failures.back().offset || failure == failures.back()))
+        return;
+    if (!failures.empty() && failure.offset > failures.back().offset)
+        failures.clear();
+    failures.push_back(failure);
+    error_stack_built = false;
+}
+
+void Xpp::Parser::push_failure(Xpp::FailureKind kind, const Xpp::Rule &rule, size_t symbol, size_t count)
+{
+    record_failure({kind, static_cast<uint32_t>(&rule - grammar->get_rules().data()), static_cast<uint32_t>(symbol), static_cast<uint32_t>(count), parse_index.char_index});
+}
+
+Xpp::SyntaxError Xpp::Parser::describe_failure(const Xpp::Failure &failure) const
+{
+    std::string_view text;
+    if (failure.kind == FAILURE_CONSTANT || failure.kind == FAILURE_FOLDED_CONSTANT)
+        text = grammar->get_constants().get_constant(failure.symbol);
+    // The other kinds before FAILURE_ALTERNATIVE expect a reference
+    else if (failure.kind < FAILURE_ALTERNATIVE)
+        text = grammar->get_symbols()[failure.symbol];
+    return Xpp::format_failure(failure.kind, grammar->get_rules()[failure.rule].name, text, failure.count, failure.offset, lines);
+}
+
+void Xpp::Parser::advance_to(const std::vector<Xpp::Token> &tokens, size_t char_index)
+{
+    parse_index.char_index = char_index;
+    while (parse_index.token_index < tokens.size() && tokens[parse_index.token_index].index < char_index)
+        parse_index.token_index++;
+}
+
+void Xpp::Parser::backtrack(Xpp::AST &ast, Xpp::Index index, size_t children)
+{
+    parse_index = index;
+    ast.get_children().resize(children);
 }
 
-bool Xpp::Parser::analyze_expression(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, Xpp::RuleExpression &exp, const std::string &rule_name)
+bool Xpp::Parser::analyze_rule(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Rule &rule)
 {
-    for (auto el : exp)
+    Index last_index = parse_index;
+    size_t children = ast.get_children().size();
+    bool tried = false;
+    for (const auto &rule_exp : rule.expressions)
+    {
+        // The last expression is always tried, so the failure is the one of a parse without prediction
+        if (&rule_exp != &rule.expressions.back() && !is_viable(rule_exp.get_first_set(), tokens))
+        {
+            prediction_statistics.expressions_pruned++;
+            continue;
+        }
+        prediction_statistics.expressions_tried++;
+        tried = true;
+        begin_expression(rule);
+        bool matched = analyze_expression(ast, tokens, rule_exp, rule);
+        end_expression(rule, last_index.char_index, matched);
+        if (matched)
+            return true;
+        backtrack(ast, last_index, children);
+    }
+    if (failures.empty() || !tried)
+        push_failure(FAILURE_NO_EXPRESSION, rule);
+    return false;
+}
+
+bool Xpp::Parser::analyze_expression(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::RuleExpression &exp, const Xpp::Rule &rule)
+{
+    bool matched = true;
+    size_t start = parse_index.char_index;
+    for (const auto &el : exp)
     {
+        if (el.edge != EDGE_NONE && !match_edge(tokens, rule, el.edge, start))
+            return false;
         switch (el.type)
         {
         case ExpressionElementType::CONSTANT_TERMINAL:
-            return analyze_constant(ast, tokens, el, rule_name);
+            matched = analyze_constant(ast, tokens, el, rule);
+            break;
         case ExpressionElementType::ALTERNATIVE:
-            return analyze_alternative(ast, tokens, el, rule_name);
+            matched = analyze_alternative(ast, tokens, el, rule);
+            break;
         case ExpressionElementType::RULE_REFERENCE:
-            return analyze_reference(ast, tokens, el, rule_name);
+            matched = analyze_reference(ast, tokens, el.references[0], rule);
+            break;
         }
+        if (!matched)
+            return false;
     }
-    return false;
+    return exp.get_end_edge() == EDGE_NONE || match_edge(tokens, rule, exp.get_end_edge(), start);
 }
 
-bool Xpp::Parser::analyze_constant(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::match_edge(const std::vector<Xpp::Token> &tokens, const Xpp::Rule &rule, int edge, size_t start)
 {
-    for (size_t i = 0; i < el.value.length(); i++)
+    size_t char_index = parse_index.char_index;
+    if (edge & EDGE_SKIP_SPACES)
     {
-        if (el.value[i] != tokens[parse_index.token_index].value[parse_index.char_index])
+        size_t length = Scanner::scan(CLASS_SPACE, input.data() + char_index, input.length() - char_index);
+        // The scan reads the spaces and the byte that stopped it
+        mark_read(char_index + length + 1);
+        // After a space the element always starts a new word
+        if (length != 0)
         {
-            error_stack.push({EXPECTED_TOKEN, "'" + std::string(1, el.value[i]) + "' was expected", tokens[parse_index.token_index].index, tokens[parse_index.token_index].column, tokens[parse_index.token_index].line});
-            return false;
+            advance_to(tokens, char_index + length);
+            return true;
         }
-        parse_index.char_index++;
-        if (parse_index.char_index >= tokens[parse_index.token_index].value.length())
-            parse_index = {parse_index.token_index + 1, 0};
     }
-    ast.push_child({rule_name, el.value});
+    // Only the bytes matched by the expression can end a word
+    if ((edge & EDGE_BOUNDARY) == 0 || char_index == start || char_index >= input.length())
+        return true;
+    mark_read(char_index + 1);
+    if (!Scanner::is_in_class(CLASS_IDENTIFIER, input[char_index - 1]) || !Scanner::is_in_class(CLASS_IDENTIFIER, input[char_index]))
+        return true;
+    push_failure(FAILURE_BOUNDARY, rule);
+    return false;
+}
+
+bool Xpp::Parser::analyze_constant(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const Xpp::Rule &rule)
+{
+    if (el.case_insensitive != CASE_INSENSITIVE_CLEAR)
+        return match_folded_constant(ast, tokens, rule, el.constant_id, el.folded_value, el.case_insensitive == CASE_INSENSITIVE_STRICT);
+    return match_constant(ast, tokens, rule, el.constant_id, el.value);
+}
+
+bool Xpp::Parser::match_folded_constant(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::Rule &rule, size_t constant_id, std::string_view folded, bool strict)
+{
+    if (!spend_step())
+        return false;
+    size_t char_index = parse_index.char_index;
+    mark_read(std::min(char_index + folded.length(), input.length() + 1));
+    if (input.length() - char_index < folded.length() || !Scanner::equals_folded(input.data() + char_index, folded.data(), folded.length(), strict))
+    {
+        push_failure(FAILURE_FOLDED_CONSTANT, rule, constant_id);
+        return false;
+    }
+    advance_to(tokens, char_index + folded.length());
+    emit_terminal(ast, rule, char_index, folded.length());
     return true;
 }
 
-bool Xpp::Parser::analyze_reference(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::match_constant(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::Rule &rule, size_t constant_id, std::string_view value)
 {
-    switch (el.references[0].quantifier.type)
+    if (!spend_step())
+        return false;
+    size_t char_index = parse_index.char_index;
+    // Every constant that starts at this offset is found with a single walk of the trie
+    if (probe_index != char_index)
+    {
+        grammar->get_constants().probe(input, char_index, probe_path);
+        probe_index = char_index;
+    }
+    // The walk reads the matched bytes and the one that stopped it
+    mark_read(char_index + probe_path.size());
+    if (!grammar->get_constants().matches(probe_path, constant_id))
+    {
+        std::string_view next = input.substr(char_index, value.length());
+        size_t i = std::mismatch(next.begin(), next.end(), value.begin()).first - next.begin();
+        push_failure(FAILURE_CONSTANT, rule, constant_id, i);
+        return false;
+    }
+    advance_to(tokens, char_index + value.length());
+    emit_terminal(ast, rule, char_index, value.length());
+    return true;
+}
+
+bool Xpp::Parser::analyze_reference(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
+{
+    if (ref.kind != REFERENCE_RULE && ref.kind != REFERENCE_TERMINAL)
+        return analyze_implicit_terminal(ast, tokens, ref, rule);
+
+    switch (ref.quantifier.type)
     {
         case NONE:
-            return analyze_single_reference(ast, tokens, el, rule_name);
+            return analyze_single_reference(ast, tokens, ref, rule);
         case ZERO_OR_ONE:
-            return analyze_zero_or_one(ast, tokens, el, rule_name);
+            return analyze_zero_or_one(ast, tokens, ref, rule);
         case ZERO_OR_MORE:
-            return analyze_zero_or_more(ast, tokens, el, rule_name);
+            return analyze_zero_or_more(ast, tokens, ref, rule);
         case ONE_OR_MORE:
-            return analyze_one_or_more(ast, tokens, el, rule_name);
+            return analyze_one_or_more(ast, tokens, ref, rule);
         case EXACT_VALUE:
-            return analyze_exact_quantity(ast, tokens, el, rule_name);
+            return analyze_exact_quantity(ast, tokens, ref, rule);
         case EXACT_RANGE:
-            return analyze_exact_range(ast, tokens, el, rule_name);
+            return analyze_exact_range(ast, tokens, ref, rule);
     }
     return false;
 }
 
-bool Xpp::Parser::analyze_single_reference(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::analyze_single_reference(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
 {
-    Xpp::Rule *rule = find_rule(el.references[0].reference_to);
-    Xpp::TerminalRule *terminal = find_terminal_rule(el.references[0].reference_to);
-    if (rule == nullptr)
+    if (!spend_step())
+        return false;
+    if (ref.kind == REFERENCE_TERMINAL)
     {
-        if (tokens[parse_index.token_index].from.name == terminal->name)
+        const Xpp::Token *token = parse_index.token_index < tokens.size() ? &tokens[parse_index.token_index] : nullptr;
+        if (token != nullptr && token->index == parse_index.char_index && token->terminal == ref.id)
         {
-            ast.push_child({rule_name, tokens[parse_index.token_index].value});
-            this->parse_index = {parse_index.token_index + 1, 0};
+            emit_terminal(ast, rule, token->index, token->length);
+            mark_read(token->index + token->length);
+            this->parse_index = {parse_index.token_index + 1, token->index + token->length};
             return true;
         }
+        mark_read(parse_index.char_index + 1);
+        push_failure(FAILURE_REFERENCE, rule, ref.symbol);
         return false;
     }
 
-    try
-    {
-        analyze_rule(ast, tokens, *rule);
+    const Xpp::Rule *target = &grammar->get_rules()[ref.id];
+    Index last_index = parse_index;
+    bool matched;
+    if (reuse_rule(ast, tokens, ref.id))
         return true;
-    }
-    catch (const Xpp::SyntaxErrorException e)
+    if (replay_rule(ast, ref.id, matched))
+        return matched;
+
+    // The reads of the rule are measured from its start and added to the ones of the enclosing rule at the end
+    size_t outer_read = read_end;
+    read_end = last_index.char_index;
+    // Events do not need the node, and a default one does not allocate
+    Xpp::AST child = events != nullptr ? Xpp::AST() : Xpp::AST(target->name, std::vector<Xpp::AST>{});
+    child.set_span(last_index.char_index, 0, 0);
+    if (!analyze_rule(child, tokens, *target))
     {
-        error_stack.push({UNMATCHED_RULE, "Cannot match '" + rule->name + "' rule. Use 'get_error_stack' to get the error stack.", tokens[parse_index.token_index].index, tokens[parse_index.token_index].column, tokens[parse_index.token_index].line});
+        rule_failed(ref.id, last_index, outer_read);
         return false;
     }
-    return false;
+    rule_matched(ast, ref.id, last_index, outer_read, std::move(child));
+    return true;
 }
 
-bool Xpp::Parser::analyze_alternative(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::replay_rule(Xpp::AST &ast, size_t rule_id, bool &matched)
+{
+    if (!packrat_options.enabled || events != nullptr)
+        return false;
+    const Xpp::PackratResult *result = packrat_cache.find(rule_id, parse_index.char_index);
+    if (result == nullptr)
+        return false;
+    matched = result->matched;
+    mark_read(result->read_end);
+    if (matched)
+    {
+        attach(ast, result->node);
+        parse_index = result->end;
+        return true;
+    }
+    record_failure(result->failure);
+    record_failure({FAILURE_RULE, static_cast<uint32_t>(rule_id), 0, 0, result->failure.offset});
+    return true;
+}
+
+void Xpp::Parser::rule_matched(Xpp::AST &ast, size_t rule_id, Index start, size_t outer_read, Xpp::AST child)
+{
+    mark_read(outer_read);
+    if (events != nullptr)
+        return;
+    child.set_span(start.char_index, parse_index.char_index - start.char_index, read_end - start.char_index);
+    if (packrat_options.enabled)
+        packrat_cache.insert(rule_id, start.char_index, {true, parse_index, child, {}, read_end});
+    attach(ast, std::move(child));
+}
+
+void Xpp::Parser::rule_failed(size_t rule_id, Index start, size_t outer_read)
+{
+    if (packrat_options.enabled && events == nullptr)
+        packrat_cache.insert(rule_id, start.char_index, {false, start, {}, last_failure, read_end});
+    mark_read(outer_read);
+    record_failure({FAILURE_RULE, static_cast<uint32_t>(rule_id), 0, 0, last_failure.offset});
+    parse_index = start;
+}
+
+bool Xpp::Parser::analyze_alternative(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const Xpp::Rule &rule)
 {
     Index last_index = parse_index;
-    for (auto ref : el.references)
+    for (const auto &ref : el.references)
     {
         parse_index = last_index;
-        if (analyze_reference(ast, tokens, {RULE_REFERENCE, "", {ref}}, rule_name))
+        if (!is_viable(ref.first_set, tokens))
+        {
+            prediction_statistics.alternatives_pruned++;
+            continue;
+        }
+        prediction_statistics.alternatives_tried++;
+        if (analyze_reference(ast, tokens, ref, rule))
         {
             return true;
         }
     }
 
-    error_stack.push({UNMATCHED_RULE, "No match found on the alternative in the rule '" + rule_name + "'. Use 'get_error_stack' to get the error stack.", tokens[parse_index.token_index].index, tokens[parse_index.token_index].column, tokens[parse_index.token_index].line});
+    parse_index = last_index;
+    push_failure(FAILURE_ALTERNATIVE, rule);
     return false;
 }
 
-bool Xpp::Parser::analyze_zero_or_one(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::analyze_zero_or_one(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
 {
     Index last_index = parse_index;
-    if (analyze_single_reference(ast, tokens, el, rule_name))
+    if (analyze_single_reference(ast, tokens, ref, rule))
     {
         return true;
     }
@@ -358,10 +919,10 @@ bool Xpp::Parser::analyze_zero_or_one(Xpp::AST &ast, const std::vector<Xpp::Toke
     return true;
 }
 
-bool Xpp::Parser::analyze_zero_or_more(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::analyze_zero_or_more(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
 {
     Index last_index = parse_index;
-    while (analyze_single_reference(ast, tokens, el, rule_name))
+    while (analyze_single_reference(ast, tokens, ref, rule) && parse_index.char_index != last_index.char_index)
     {
         last_index = parse_index;
     }
@@ -369,44 +930,120 @@ bool Xpp::Parser::analyze_zero_or_more(Xpp::AST &ast, const std::vector<Xpp::Tok
     return true;
 }
 
-bool Xpp::Parser::analyze_one_or_more(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::analyze_one_or_more(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
 {
     Index last_index = parse_index;
     bool error = true;
-    while (analyze_single_reference(ast, tokens, el, rule_name))
+    while (analyze_single_reference(ast, tokens, ref, rule))
     {
-        last_index = parse_index;
         error = false;
+        if (parse_index.char_index == last_index.char_index)
+            break;
+        last_index = parse_index;
     }
     parse_index = last_index;
     if (error)
     {
-        error_stack.push({UNMATCHED_RULE, "'" + rule_name + "' was expected at least once. Use 'get_error_stack' to get the error stack.", tokens[parse_index.token_index].index, tokens[parse_index.token_index].column, tokens[parse_index.token_index].line});
+        push_failure(FAILURE_ONE_OR_MORE, rule, ref.symbol);
         return false;
     }
     return true;
 }
 
-bool Xpp::Parser::analyze_exact_quantity(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::analyze_exact_quantity(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
 {
     Index last_index = parse_index;
-    size_t i = 0;
-    while (analyze_single_reference(ast, tokens, el, rule_name))
+    size_t children = ast.get_children().size();
+    if (events != nullptr)
+        events->begin();
+    for (size_t i = 0; i < ref.quantifier.x_value; i++)
     {
-        i++;
+        if (!analyze_single_reference(ast, tokens, ref, rule))
+        {
+            if (events != nullptr)
+                events->rollback();
+            backtrack(ast, last_index, children);
+            push_failure(FAILURE_EXACT_VALUE, rule, ref.symbol, ref.quantifier.x_value);
+            return false;
+        }
     }
-    parse_index = last_index;
+    if (events != nullptr)
+        events->commit();
     return true;
 }
 
-bool Xpp::Parser::analyze_exact_range(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionElement &el, const std::string &rule_name)
+bool Xpp::Parser::analyze_exact_range(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
 {
+    Index start_index = parse_index;
     Index last_index = parse_index;
+    size_t children = ast.get_children().size();
     size_t i = 0;
-    while (analyze_single_reference(ast, tokens, el, rule_name))
+    if (events != nullptr)
+        events->begin();
+    while (i < ref.quantifier.y_value && analyze_single_reference(ast, tokens, ref, rule))
     {
+        last_index = parse_index;
         i++;
     }
     parse_index = last_index;
+    if (i < ref.quantifier.x_value)
+    {
+        if (events != nullptr)
+            events->rollback();
+        backtrack(ast, start_index, children);
+        push_failure(FAILURE_EXACT_RANGE, rule, ref.symbol, ref.quantifier.x_value);
+        return false;
+    }
+    if (events != nullptr)
+        events->commit();
+    return true;
+}
+
+bool Xpp::Parser::analyze_implicit_terminal(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::ExpressionReference &ref, const Xpp::Rule &rule)
+{
+    size_t min = 1;
+    size_t max = 1;
+    switch (ref.quantifier.type)
+    {
+    case NONE:
+        break;
+    case ZERO_OR_ONE:
+        min = 0;
+        break;
+    case ZERO_OR_MORE:
+        min = 0;
+        max = SIZE_MAX;
+        break;
+    case ONE_OR_MORE:
+        max = SIZE_MAX;
+        break;
+    case EXACT_VALUE:
+        min = max = ref.quantifier.x_value;
+        break;
+    case EXACT_RANGE:
+        min = ref.quantifier.x_value;
+        max = ref.quantifier.y_value;
+        break;
+    }
+    return match_implicit_terminal(ast, tokens, rule, ref.kind, ref.id, min, max, ref.symbol);
+}
+
+bool Xpp::Parser::match_implicit_terminal(Xpp::AST &ast, const std::vector<Xpp::Token> &tokens, const Xpp::Rule &rule, Xpp::ReferenceKind kind, size_t id, size_t min, size_t max, size_t symbol)
+{
+    if (!spend_step())
+        return false;
+    size_t char_index = parse_index.char_index;
+    Xpp::ImplicitMatch match = Xpp::scan_implicit_terminal(kind, id, min, max, input.substr(char_index));
+    mark_read(char_index + match.read);
+    if (match.count < min)
+    {
+        push_failure(FAILURE_REFERENCE, rule, symbol);
+        return false;
+    }
+    if (match.length > 0)
+    {
+        emit_terminal(ast, rule, char_index, match.length);
+        advance_to(tokens, char_index + match.length);
+    }
     return true;
-} 
\ No newline at end of file
+}
@@ -1,6 +1,140 @@
 #include "xparser.hh"
+#include "JsonParser.hh"
+#include "static_grammar.hh"
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <initializer_list>
+#include <thread>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &description)
+{
+    if (condition)
+        return;
+    std::cout << "FAILED: " << description << std::endl;
+    failures++;
+}
+
+// The same grammar as static_grammar, written in C++
+using StaticDocument = Xpp::StaticParser<
+    Xpp::StaticRule<"document", "<value><newLine?><eof>">,
+    Xpp::StaticRule<"value", "<object|array|integer>", "\"<alnum*>\"", "[i]null", "#<hexDigit{6}>", "v<digit{1:3}>">,
+    Xpp::StaticRule<"object", "{<member*><pair>}", "{}">,
+    Xpp::StaticRule<"member", "<pair>,">,
+    Xpp::StaticRule<"pair", "\"<alpha+>\":<value>">,
+    Xpp::StaticRule<"array", "\\[<value{2}>\\]", "\\[<item*>\\]">,
+    Xpp::StaticRule<"item", "<value><space?>">>;
+
+static const char *static_grammar = R"json({"name": "document", "terminals": [], "rules": [
+    {"name": "document", "expressions": ["<value><newLine?><eof>"]},
+    {"name": "value", "expressions": ["<object|array|integer>", "\"<alnum*>\"", "[i]null", "#<hexDigit{6}>", "v<digit{1:3}>"]},
+    {"name": "object", "expressions": ["{<member*><pair>}", "{}"]},
+    {"name": "member", "expressions": ["<pair>,"]},
+    {"name": "pair", "expressions": ["\"<alpha+>\":<value>"]},
+    {"name": "array", "expressions": ["\\[<value{2}>\\]", "\\[<item*>\\]"]},
+    {"name": "item", "expressions": ["<value><space?>"]}]})json";
+
+// A grammar with the 's' and 'b' flags, also written in C++
+using StaticStatement = Xpp::StaticParser<
+    Xpp::StaticRule<"statement", "[sb]let <identifier> = <integer|identifier> ;", "[s]{ <statement*> }">>;
+
+static const char *flags_grammar = R"json({"name": "statement", "terminals": [], "rules": [
+    {"name": "statement", "expressions": ["[sb]let <identifier> = <integer|identifier> ;", "[s]{ <statement*> }"]}]})json";
+
+static bool same_tree(Xpp::AST &a, Xpp::AST &b)
+{
+    if (a.get_rule_name() != b.get_rule_name() || a.is_terminal() != b.is_terminal())
+        return false;
+    if (a.is_terminal())
+        return a.get_value_view() == b.get_value_view();
+    if (a.get_children().size() != b.get_children().size())
+        return false;
+    for (size_t i = 0; i < a.get_children().size(); i++)
+    {
+        if (!same_tree(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+// Every input must be parsed by both parsers with the same AST or fail at the same index with the same message
+template <typename P>
+static bool same_results(Xpp::Parser &expected_parser, P &actual_parser, std::initializer_list<const char *> inputs)
+{
+    for (const char *input : inputs)
+    {
+        Xpp::ParseResult expected = expected_parser.try_generate_ast(input);
+        Xpp::ParseResult actual = actual_parser.try_generate_ast(input);
+        if (expected.success != actual.success)
+            return false;
+        if (expected.success ? !same_tree(expected.ast, actual.ast) : expected.error.index != actual.error.index || expected.error.message != actual.error.message)
+            return false;
+    }
+    return true;
+}
+
+static std::string serialize(Xpp::AST &ast)
+{
+    if (ast.is_terminal())
+        return "[" + ast.get_rule_name() + ":" + ast.get_value() + "]";
+    std::string text = "(" + ast.get_rule_name();
+    for (Xpp::AST &child : ast.get_children())
+        text += serialize(child);
+    return text + ")";
+}
+
+// Writes the events like serialize writes the AST, a rollback truncates the text to its length at the begin
+class EventRecorder : public Xpp::EventHandler
+{
+public:
+    std::string text;
+    std::vector<size_t> attempts;
+    size_t max_attempts = 0;
+
+    void enter_rule(const Xpp::Rule &rule, size_t) override { text += "(" + rule.name; }
+    void exit_rule(const Xpp::Rule &, std::string_view) override { text += ")"; }
+    void terminal(const Xpp::Rule &rule, std::string_view span) override { text += "[" + rule.name + ":" + std::string(span) + "]"; }
+    void begin() override
+    {
+        attempts.push_back(text.size());
+        max_attempts = std::max(max_attempts, attempts.size());
+    }
+    void commit() override { attempts.pop_back(); }
+    void rollback() override
+    {
+        text.resize(attempts.back());
+        attempts.pop_back();
+    }
+};
+
+static bool same_events(Xpp::Parser &parser, const std::string &input)
+{
+    Xpp::ParseResult result = parser.try_generate_ast(input);
+    EventRecorder recorder;
+    EventRecorder forwarded;
+    Xpp::EventBuffer buffer(forwarded);
+    Xpp::ParseResult events = parser.parse_events(input, recorder);
+    parser.parse_events(input, buffer);
+    if (!result)
+        return !events && events.error.index == result.error.index;
+    std::string expected = serialize(result.ast);
+    return events && recorder.attempts.empty() && recorder.text == expected && forwarded.text == expected;
+}
+
+static bool parses(Xpp::Parser &parser, const std::string &input)
+{
+    try
+    {
+        parser.generate_ast(input);
+        return true;
+    }
+    catch (const Xpp::SyntaxErrorException &e)
+    {
+        return false;
+    }
+}
 
 int main(int argc, char **argv)
 {
@@ -9,12 +143,368 @@ int main(int argc, char **argv)
         std::ifstream file;
         file.open("json/grammar1.json");
         Xpp::Parser parser(file);
-        Xpp::AST ast = parser.generate_ast("def \"asdfasdf\"");
-        return 0;
+
+        std::vector<Xpp::Token> tokens = parser.tokenize("def \"asdfasdf\";");
+        check(tokens.size() == 2, "tokens do not overlap");
+        check(tokens.size() == 2 && parser.get_terminal_rule(tokens[0]).name == "identifier" && tokens[0].index == 0, "'def' is an identifier");
+        check(tokens.size() == 2 && parser.get_terminal_rule(tokens[1]).name == "lolly" && tokens[1].index == 4, "user-defined terminals come first");
+
+        tokens = parser.tokenize("def\n\n  \"asdfasdf\";");
+        check(tokens.size() == 2 && parser.get_column_line(tokens[1].index) == std::pair<size_t, size_t>(2, 2), "line and column of a token");
+
+        Xpp::AST ast = parser.generate_ast("def \"asdfasdf\";");
+        check(ast.get_children().size() == 3, "every element of the expression is in the AST");
+        check(!parses(parser, "def \"asdfasdf\""), "';' is required");
+        try
+        {
+            parser.generate_ast("def;");
+        }
+        catch (const std::exception &e)
+        {
+            check(std::string(e.what()).find("was expected") != std::string::npos, "the message of a syntax error is kept");
+        }
+
+        std::ifstream json_file;
+        json_file.open("json/jsonGrammar.json");
+        Xpp::Parser json_parser(json_file);
+        check(json_parser.tokenize("[true,null]").size() == 2, "a grammar with alternatives is loaded");
+        Xpp::AST json_ast = json_parser.generate_ast("[]");
+        check(json_ast.get_children().size() == 1 && json_ast[0].get_rule_name() == "array", "a sub-rule is a node of the AST");
+        check(parses(json_parser, "{\"a\" : 1,\"b\" : [true,null]}"), "nested JSON values");
+        check(parses(json_parser, "[1,2.5,\"three\"]"), "JSON array");
+        check(!parses(json_parser, "[1,2"), "unterminated JSON array");
+        Xpp::ParseResult result = json_parser.try_generate_ast("[1,2");
+        check(!result && result.error.index == 4, "try_generate_ast returns the error");
+        result = json_parser.try_generate_ast("[1,2]");
+        check(result && result.ast.get_children().size() == 1, "try_generate_ast returns the AST");
+        check(!parses(json_parser, "[1,2") && json_parser.get_last_error().index == 4 && json_parser.get_last_error().message == "']' was expected", "errors are reported at the farthest offset");
+
+        Xpp::Parser quantifier_parser(std::string(R"json({"name": "quantifiers", "terminals": [], "rules": [
+            {"name": "list", "expressions": ["<optional*>?", "<optional+>!"]},
+            {"name": "optional", "expressions": ["<item?>"]},
+            {"name": "item", "expressions": ["a"]}]})json"));
+        check(parses(quantifier_parser, "aaa?") && parses(quantifier_parser, "?") && parses(quantifier_parser, "aa!"), "a repeated reference that matches nothing stops the repetition");
+
+        // The keys of a JSON array are strings, so "10" comes before "2"
+        Xpp::Parser order_parser(std::string(R"json({"name": "order", "terminals": [], "rules": [{"name": "letters", "expressions": [
+            "0", "1", "a", "3", "4", "5", "6", "7", "8", "9", "ab"]}]})json"));
+        check(order_parser.generate_ast("ab")[0].get_value() == "a", "the arrays of the grammar are read in order");
+
+        std::string nested = "{\"a\" : [1,{\"b\" : [2.5,\"c\",null]},true],\"d\" : {}}";
+        Xpp::AST plain_ast = json_parser.generate_ast(nested);
+        json_parser.set_packrat_options({true, 0});
+        Xpp::AST packrat_ast = json_parser.generate_ast(nested);
+        check(same_tree(plain_ast, packrat_ast), "packrat parsing builds the same AST");
+        json_parser.set_packrat_options({true, 2});
+        packrat_ast = json_parser.generate_ast(nested);
+        check(same_tree(plain_ast, packrat_ast), "packrat parsing with a bounded cache");
+        check(!parses(json_parser, "[1,{\"a\" : }]"), "packrat parsing reports errors");
+        json_parser.set_packrat_options({});
+
+        // Every level is matched, then replayed from the cache after the first expression fails
+        Xpp::Parser nested_parser{std::string(R"json({"name": "list", "terminals": [], "rules": [
+            {"name": "list", "expressions": ["(<list?>)x", "(<list?>)"]}]})json")};
+        nested_parser.set_packrat_options({true, 0});
+        bool deep_packrat = true;
+        for (Xpp::ParserEngine engine : {Xpp::ENGINE_ITERATIVE, Xpp::ENGINE_BYTECODE})
+        {
+            nested_parser.set_engine(engine);
+            size_t depth = 0;
+            auto started = std::chrono::steady_clock::now();
+            for (size_t levels : {25000, 50000, 100000})
+            {
+                Xpp::ParseResult deep = nested_parser.try_generate_ast(std::string(levels, '(') + std::string(levels, ')'));
+                Xpp::AST *node = &deep.ast;
+                for (depth = 0; deep && node->get_children().size() == 3; depth++)
+                    node = &(*node)[1];
+                deep_packrat = deep_packrat && depth == levels - 1;
+            }
+            // Copying the cached nodes made the time grow with the square of the depth
+            deep_packrat = deep_packrat && std::chrono::steady_clock::now() - started < std::chrono::seconds(10);
+        }
+        check(deep_packrat, "packrat parsing scales linearly with the depth of the input");
+
+        // The last expression of a rule is never pruned, and the ones of the JSON grammar share their FIRST sets
+        Xpp::Parser choice_parser(std::string(R"json({"name": "choice", "terminals": [], "rules": [
+            {"name": "choice", "expressions": ["a", "b"]}]})json"));
+        check(parses(choice_parser, "b") && choice_parser.get_prediction_statistics().expressions_pruned == 1 && json_parser.get_prediction_statistics().alternatives_pruned > 0, "FIRST sets prune expressions and alternatives");
+        json_parser.set_prediction(false);
+        Xpp::AST unpredicted_ast = json_parser.generate_ast(nested);
+        json_parser.set_prediction(true);
+        check(same_tree(plain_ast, unpredicted_ast), "prediction does not change the AST");
+        Xpp::Parser tail_parser(std::string(R"json({"name": "tail", "terminals": [], "rules": [
+            {"name": "word", "expressions": ["o<alpha|digit>"]}]})json"));
+        check(parses(tail_parser, "o1") && parses(tail_parser, "ox"), "the references after the first element are predicted");
+
+        json_parser.set_engine(Xpp::ENGINE_ITERATIVE);
+        Xpp::AST iterative_ast = json_parser.generate_ast(nested);
+        check(same_tree(plain_ast, iterative_ast), "the iterative engine builds the same AST");
+        check(!parses(json_parser, "[1,{\"a\" : }]"), "the iterative engine reports errors");
+        json_parser.set_engine(Xpp::ENGINE_RECURSIVE);
+
+        std::initializer_list<const char *> wrong_json = {"[1,2", "[1,{\"a\" : }]", "{\"a\" 1}", "[tru]", "", "[1,2]x", "true"};
+        Xpp::Parser unpredicted_parser(json_parser.get_grammar());
+        unpredicted_parser.set_prediction(false);
+        bool same_errors = true;
+        for (Xpp::ParserEngine engine : {Xpp::ENGINE_RECURSIVE, Xpp::ENGINE_ITERATIVE, Xpp::ENGINE_BYTECODE})
+        {
+            json_parser.set_engine(engine);
+            unpredicted_parser.set_engine(engine);
+            same_errors = same_errors && same_results(unpredicted_parser, json_parser, wrong_json);
+        }
+        json_parser.set_engine(Xpp::ENGINE_RECURSIVE);
+        check(same_errors, "prediction does not change the errors");
+        Xpp::Parser bytecode_parser(json_parser.get_grammar());
+        bytecode_parser.set_engine(Xpp::ENGINE_BYTECODE);
+        Xpp::AST bytecode_ast = bytecode_parser.generate_ast(nested);
+        check(same_tree(plain_ast, bytecode_ast) && bytecode_ast[0].get_lookahead() == plain_ast[0].get_lookahead(), "the bytecode engine builds the same AST");
+        check(same_results(json_parser, bytecode_parser, wrong_json), "the bytecode engine reports the same errors");
+        std::string listing = json_parser.get_grammar()->get_bytecode().dump(*json_parser.get_grammar());
+        check(listing.find("CALL") != std::string::npos && listing.find("NO_EXPRESSION") != std::string::npos, "the bytecode can be dumped");
+
+        JsonParser generated_parser;
+        Xpp::AST generated_ast = generated_parser.generate_ast(nested);
+        check(same_tree(plain_ast, generated_ast) && generated_ast[0].get_length() == plain_ast[0].get_length(), "the generated parser builds the same AST");
+        check(same_results(json_parser, generated_parser, wrong_json), "the generated parser reports the same errors");
+
+        Xpp::Parser document_parser{std::string(static_grammar)};
+        document_parser.set_prediction(false);
+        StaticDocument static_parser;
+        check(same_results(document_parser, static_parser, {"{\"a\":1,\"b\":[NuLl \"x1\" #00ff7F]}\n", "[v12v3]", "[1 2 3]", "{}", "[{\"a\":[]} v1234]", "{\"a\":}", "#12345", "[1 ", ""}), "a compile-time grammar parses like the same grammar loaded at runtime");
+        Xpp::Parser document_bytecode(document_parser.get_grammar());
+        document_bytecode.set_engine(Xpp::ENGINE_BYTECODE);
+        document_bytecode.set_prediction(false);
+        check(same_results(document_parser, document_bytecode, {"[v12v3]", "[v]", "#12345g", "#00ff7F", "[1 2 3]", "{\"a\":1,\"b\":[NuLl \"x1\" #00ff7F]}\n", "[v1234]"}), "the bytecode engine matches quantifiers, classes and case-insensitive constants");
+        check(document_parser.try_generate_ast("[v12v3]").success && !document_parser.try_generate_ast("[v]").success && !document_parser.try_generate_ast("#12345g").success, "exact and range quantifiers");
+
+        Xpp::Parser nesting_parser(std::string(R"json({"name": "nesting", "terminals": [], "rules": [{"name": "list", "expressions": ["(<list?>)"]}]})json"));
+        nesting_parser.set_engine(Xpp::ENGINE_ITERATIVE);
+        check(parses(nesting_parser, std::string(100000, '(') + std::string(100000, ')')), "the depth of the iterative engine is not limited by the stack");
+        check(!parses(nesting_parser, std::string(100000, '(') + std::string(99999, ')')), "unbalanced deep input");
+        nesting_parser.set_engine(Xpp::ENGINE_BYTECODE);
+        check(parses(nesting_parser, std::string(100000, '(') + std::string(100000, ')')), "the depth of the bytecode engine is not limited by the stack");
+
+        std::shared_ptr<const Xpp::CompiledGrammar> shared_grammar = json_parser.get_grammar();
+        std::vector<char> shared_results(4, false);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < shared_results.size(); i++)
+        {
+            threads.emplace_back([&, i]
+            {
+                Xpp::Parser thread_parser(shared_grammar);
+                bool same_ast = true;
+                for (size_t j = 0; j < 50; j++)
+                {
+                    Xpp::AST thread_ast = thread_parser.generate_ast(nested);
+                    same_ast = same_ast && same_tree(plain_ast, thread_ast);
+                }
+                shared_results[i] = same_ast;
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+        check(std::find(shared_results.begin(), shared_results.end(), false) == shared_results.end(), "parsers on different threads share a compiled grammar");
+
+        std::vector<std::string> documents;
+        for (size_t i = 0; i < 200; i++)
+            documents.push_back(i % 7 == 3 ? "[" + std::to_string(i) + "," : "[" + std::to_string(i) + ",{\"a\" : true}]");
+        std::vector<std::string_view> document_views(documents.begin(), documents.end());
+        json_parser.set_batch_options({3});
+        std::vector<Xpp::ParseResult> batch = json_parser.parse_batch(document_views);
+        bool ordered = batch.size() == documents.size();
+        for (size_t i = 0; ordered && i < batch.size(); i++)
+        {
+            if (i % 7 == 3)
+                ordered = !batch[i] && batch[i].error.index == documents[i].size();
+            else
+                ordered = batch[i] && batch[i].ast[0][1][0][0].get_value_view() == std::to_string(i);
+        }
+        check(ordered, "parse_batch returns the results in the order of the inputs");
+
+        std::ifstream incremental_file;
+        incremental_file.open("json/jsonGrammar.json");
+        Xpp::Parser incremental_parser(incremental_file);
+        incremental_parser.set_incremental(true);
+        Xpp::ParseResult edited = incremental_parser.try_generate_ast(nested);
+        edited = incremental_parser.reparse(std::move(edited.ast), {{8, 1, "42"}, {0, 0, "[7,"}, {std::string("[7,").size() + nested.size() + 1, 0, "]"}});
+        Xpp::AST expected = json_parser.generate_ast("[7," + nested.substr(0, 8) + "42" + nested.substr(9) + "]");
+        check(edited && same_tree(edited.ast, expected), "reparse applies the edits in order");
+        edited = incremental_parser.reparse(std::move(edited.ast), {{3, 3, ""}});
+        check(!edited && edited.error.index == json_parser.try_generate_ast("[7," + nested.substr(3, 5) + "42" + nested.substr(9) + "]").error.index, "reparse reports the error of a full parse");
+        edited = incremental_parser.try_generate_ast("[1,{\"a\" : true}]");
+        edited = incremental_parser.reparse(std::move(edited.ast), {{10, 4, "false"}});
+        expected = json_parser.generate_ast("[1,{\"a\" : false}]");
+        check(edited && same_tree(edited.ast, expected), "reparse replaces a terminal");
+        Xpp::ParseResult stale = incremental_parser.try_generate_ast(std::string("[true,1,1,1,1]"));
+        edited = incremental_parser.try_generate_ast(std::string("[null,2,2,2,2]"));
+        edited = incremental_parser.reparse(std::move(stale.ast), {{12, 1, "3"}});
+        expected = json_parser.generate_ast("[null,2,2,2,3]");
+        check(edited && same_tree(edited.ast, expected), "reparse parses from scratch when the AST is not the one of the last input");
+
+        check(same_events(json_parser, nested) && same_events(json_parser, "[1,{\"a\" : true}"), "events describe the AST");
+        json_parser.set_engine(Xpp::ENGINE_ITERATIVE);
+        check(same_events(json_parser, nested), "events of the iterative engine");
+        json_parser.set_engine(Xpp::ENGINE_BYTECODE);
+        check(same_events(json_parser, nested) && same_events(json_parser, "[1,{\"a\" : true}"), "events of the bytecode engine");
+        json_parser.set_engine(Xpp::ENGINE_RECURSIVE);
+        EventRecorder depth_recorder;
+        std::string long_array = "[";
+        for (size_t i = 0; i < 1000; i++)
+            long_array += "1,";
+        json_parser.parse_events(long_array + "1]", depth_recorder);
+        check(depth_recorder.max_attempts < 10, "open attempts grow with the depth of the input, not its length");
+
+        Xpp::ParseBudget budget;
+        budget.max_steps = 20;
+        json_parser.set_budget(budget);
+        result = json_parser.try_generate_ast(nested);
+        check(!result && result.error.type == Xpp::STEP_LIMIT_EXCEEDED && json_parser.get_last_error().type == Xpp::STEP_LIMIT_EXCEEDED, "the step limit stops the parse");
+        json_parser.set_engine(Xpp::ENGINE_ITERATIVE);
+        result = json_parser.try_generate_ast(nested);
+        check(!result && result.error.type == Xpp::STEP_LIMIT_EXCEEDED, "the step limit stops the iterative engine");
+        json_parser.set_engine(Xpp::ENGINE_BYTECODE);
+        result = json_parser.try_generate_ast(nested);
+        check(!result && result.error.type == Xpp::STEP_LIMIT_EXCEEDED, "the step limit stops the bytecode engine");
+        json_parser.set_engine(Xpp::ENGINE_RECURSIVE);
+        budget.max_steps = 0;
+        budget.max_nodes = 10;
+        json_parser.set_budget(budget);
+        check(json_parser.try_generate_ast(nested).error.type == Xpp::NODE_LIMIT_EXCEEDED, "the node limit stops the parse");
+        budget.max_nodes = 0;
+        budget.time_limit = std::chrono::nanoseconds(1);
+        json_parser.set_budget(budget);
+        check(json_parser.try_generate_ast(long_array).error.type == Xpp::TIME_LIMIT_EXCEEDED, "the time limit stops the parse");
+        budget.time_limit = {};
+        std::shared_ptr<Xpp::CancellationToken> token = std::make_shared<Xpp::CancellationToken>();
+        budget.cancellation = token;
+        json_parser.set_budget(budget);
+        check(json_parser.try_generate_ast(nested).success, "a token that is not cancelled does not stop the parse");
+        token->cancel();
+        check(json_parser.try_generate_ast(nested).error.type == Xpp::PARSE_CANCELLED, "a cancelled token stops the parse");
+        budget = {};
+        budget.max_steps = 100000;
+        json_parser.set_budget(budget);
+        check(json_parser.try_generate_ast(nested).success && same_events(json_parser, nested), "a budget that is not exceeded does not change the result");
+        json_parser.set_budget({});
+
+        Xpp::AST mapped_ast;
+        {
+            std::ifstream scoped_file;
+            scoped_file.open("json/jsonGrammar.json");
+            Xpp::Parser scoped_parser(scoped_file);
+            mapped_ast = scoped_parser.generate_ast_from_file("json/array.json");
+        }
+        check(mapped_ast[0][0].get_value() == "[", "the AST keeps the mapped file alive");
+        check(mapped_ast[0][1][0][0].get_value_view() == "1", "values are views of the input");
+
+        std::string long_input;
+        for (size_t i = 0; i < 200; i++)
+            long_input += "\"multi\nline\" " + std::to_string(i) + " \"a\"\n";
+        std::vector<Xpp::Token> sequential = json_parser.tokenize(long_input);
+        json_parser.set_tokenizer_options({4, 7});
+        std::vector<Xpp::Token> parallel = json_parser.tokenize(long_input);
+        json_parser.set_tokenizer_options({});
+        bool same = sequential.size() == parallel.size();
+        for (size_t i = 0; same && i < sequential.size(); i++)
+            same = sequential[i].index == parallel[i].index && sequential[i].length == parallel[i].length && sequential[i].terminal == parallel[i].terminal;
+        check(same, "parallel tokenization matches the sequential one");
+
+        Xpp::Parser implicit_parser(std::string(R"({"name": "implicit", "terminals": [], "rules": [{"name": "code", "expressions": ["<digit+>-<alpha*><space?>;<eof>"]}]})"));
+        check(parses(implicit_parser, "123-abc ;"), "implicit character classes");
+        check(parses(implicit_parser, "1-;"), "optional implicit terminals");
+        check(!parses(implicit_parser, "-abc;"), "'+' requires at least one character");
+        check(!parses(implicit_parser, "1-abc;x"), "'eof' only matches at the end");
+
+        Xpp::Parser keyword_parser(std::string(R"({"name": "keywords", "terminals": [], "rules": [{"name": "code", "expressions": ["ifelse;<eof>", "if;<eof>", "i;<eof>"]}]})"));
+        check(parses(keyword_parser, "if;"), "constants that share a prefix");
+        check(parses(keyword_parser, "i;"), "constant that is a prefix of another");
+        check(same_events(keyword_parser, "i;"), "events of expressions that failed are undone");
+        check(!parses(keyword_parser, "ife;"), "partial constants do not match");
+
+        Xpp::Parser case_parser(std::string(R"({"name": "case", "terminals": [], "rules": [{"name": "code", "expressions": ["[i]select from;<eof>", "[I]insert into;<eof>"]}]})"));
+        check(parses(case_parser, "SeLeCt FROM;"), "'i' ignores the case");
+        check(parses(case_parser, "INSERT INTO;") && parses(case_parser, "insert into;"), "'I' accepts a single case");
+        check(!parses(case_parser, "Insert into;"), "'I' rejects mixed case");
+
+        bool undefined = false;
+        try
+        {
+            Xpp::Parser undefined_parser(std::string(R"({"name": "undefined", "terminals": [], "rules": [{"name": "code", "expressions": ["<digit|missing>"]}]})"));
+        }
+        catch (const std::runtime_error &e)
+        {
+            undefined = true;
+        }
+        check(undefined, "references of alternatives are resolved when the grammar is loaded");
+
+        json_parser.save_compiled("jsonGrammar.xpg");
+        Xpp::Parser image_parser;
+        image_parser.load_compiled("jsonGrammar.xpg");
+        Xpp::AST image_ast = image_parser.generate_ast(nested);
+        check(same_tree(plain_ast, image_ast), "a grammar loaded from a binary image builds the same AST");
+        check(same_results(json_parser, image_parser, wrong_json), "a grammar loaded from a binary image reports the same errors");
+        image_parser.set_engine(Xpp::ENGINE_BYTECODE);
+        image_ast = image_parser.generate_ast(nested);
+        check(same_tree(plain_ast, image_ast), "the bytecode is loaded from the binary image");
+
+        parser.save_compiled("grammar1.xpg");
+        Xpp::Parser terminal_image;
+        terminal_image.load_compiled("grammar1.xpg");
+        tokens = terminal_image.tokenize("def \"asdfasdf\";");
+        check(tokens.size() == 2 && terminal_image.get_terminal_rule(tokens[1]).name == "lolly", "user-defined terminals are loaded from the binary image");
+        document_parser.save_compiled("document.xpg");
+        Xpp::Parser document_image;
+        document_image.load_compiled("document.xpg");
+        document_image.set_prediction(false);
+        check(same_results(document_parser, document_image, {"{\"a\":1,\"b\":[NuLl \"x1\" #00ff7F]}\n", "[v12v3]", "[v]", "#12345g", "[1 2 3]"}), "case-insensitive constants and quantifiers are loaded from the binary image");
+
+        std::ifstream image_file("jsonGrammar.xpg", std::ios::binary);
+        std::string image((std::istreambuf_iterator<char>(image_file)), std::istreambuf_iterator<char>());
+        std::string damaged = image;
+        damaged[damaged.size() / 2] ^= 1;
+        bool rejected = true;
+        for (const std::string &content : {damaged, image.substr(0, image.size() - 1), std::string("{\"name\": \"json\"}")})
+        {
+            std::ofstream("damaged.xpg", std::ios::binary | std::ios::trunc) << content;
+            try
+            {
+                Xpp::Parser damaged_parser;
+                damaged_parser.load_compiled("damaged.xpg");
+                rejected = false;
+            }
+            catch (const std::runtime_error &e)
+            {
+            }
+        }
+        check(rejected, "damaged, truncated and foreign files are not loaded");
+
+        check(parses(json_parser, "[ 1,{\"a\":true} ]") && parses(json_parser, "{\"a\"  :\t1}"), "the 's' flag skips the spaces between elements");
+        Xpp::AST spaced_ast = json_parser.generate_ast("{\"a\" : 1}");
+        check(spaced_ast[0][1][1].get_value() == ":", "the 's' flag removes the spaces around constants");
+        generated_ast = generated_parser.generate_ast("[ 1,{\"a\":true} ]");
+        Xpp::AST expected_ast = json_parser.generate_ast("[ 1,{\"a\":true} ]");
+        check(same_tree(expected_ast, generated_ast), "the generated parser skips the spaces");
+        Xpp::Parser flags_parser{std::string(flags_grammar)};
+        check(parses(flags_parser, "let x=1;") && parses(flags_parser, "{let  x = y ;\t}") && parses(flags_parser, "{ {} }"), "flagged expressions with and without spaces");
+        result = flags_parser.try_generate_ast("letx = 1;");
+        check(!result && result.error.index == 3 && result.error.message == "A space was expected", "the 'b' flag requires a boundary between words");
+        StaticStatement static_statement;
+        std::initializer_list<const char *> statements = {"let x=1;", "{ let a = b;let c=1 ; }", "letx = 1;", "let x = 1", "{let y=z;}}", "let x=1 ;letx"};
+        bool same_flags = same_results(flags_parser, static_statement, statements);
+        for (Xpp::ParserEngine engine : {Xpp::ENGINE_RECURSIVE, Xpp::ENGINE_ITERATIVE, Xpp::ENGINE_BYTECODE})
+        {
+            Xpp::Parser engine_parser(flags_parser.get_grammar());
+            engine_parser.set_engine(engine);
+            same_flags = same_flags && same_results(flags_parser, engine_parser, statements);
+        }
+        check(same_flags, "every engine and StaticParser honor the 's' and 'b' flags");
+        listing = flags_parser.get_grammar()->get_bytecode().dump(*flags_parser.get_grammar());
+        check(listing.find("EDGE            spaces boundary") != std::string::npos, "the edges are compiled to bytecode");
     }
-    catch (const std::exception e)
+    catch (const std::exception &e)
     {
         std::cout << e.what() << std::endl;
+        return 1;
     }
-    return 0;
-}
\ No newline at end of file
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file xparse-gen.cc
+ * @author Simone Ancona
+ * @brief Command line tool that writes a C++ parser for a grammar
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "generator.hh"
+#include <fstream>
+#include <iostream>
+
+static bool write_file(const std::string &path, const std::string &content)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+    return !file.fail();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: xparse-gen <grammar.json> <class name> <output directory>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file;
+    file.open(argv[1]);
+    if (file.fail())
+    {
+        std::cerr << "Cannot open the grammar '" << argv[1] << "'" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        Xpp::CompiledGrammar grammar(file);
+        Xpp::CodeGenerator generator(grammar, argv[2]);
+        std::string header = std::string(argv[2]) + ".hh";
+        std::string directory = argv[3];
+        if (!write_file(directory + "/" + header, generator.generate_header()) ||
+            !write_file(directory + "/" + argv[2] + ".cc", generator.generate_source(header)))
+        {
+            std::cerr << "Cannot write the parser to '" << directory << "'" << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}